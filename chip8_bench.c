@@ -0,0 +1,116 @@
+#include "chip8_state.h"
+#include "chip8_error.h"
+#include "chip8_interpreter.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* Interpreter throughput benchmark.
+ * Build twice, with and without C8_HARDENED, to compare the masked and unchecked paths.
+ * Usage: bench [cycles] [rom path]
+ * Without a rom path, runs a built in loop of the memory and stack instructions.
+ * Build with C8_BENCH_RECOMPILED and a c8rc output to also time the recompiled ROM,
+ * and check it leaves the state exactly as the interpreter does. */
+
+#define BENCH_CYCLES_DEFAULT 100000000
+
+#ifndef C8_BENCH_RECOMPILED
+//Loop exercising FX33, FX55, FX65, DXYN, 2NNN and 00EE.
+static const uint8_t benchRom[] = {
+    0xA3, 0x00, //200: i = 0x300.
+    0x60, 0x05, //202: v0 = 5.
+    0xF0, 0x33, //204: BCD of v0 at i.
+    0xF5, 0x55, //206: store v0 to v5 at i.
+    0xF5, 0x65, //208: load v0 to v5 from i.
+    0xD0, 0x15, //20A: draw 5 rows at (v0, v1).
+    0x22, 0x14, //20C: call 214.
+    0x71, 0x01, //20E: v1 += 1.
+    0x12, 0x02, //210: jump 202.
+    0x00, 0x00, //212: padding.
+    0x00, 0xEE  //214: return.
+};
+#endif
+
+#ifdef C8_BENCH_RECOMPILED
+//Defined by the c8rc output.
+extern const uint8_t C8R_ROM[];
+extern const size_t C8R_ROM_LEN;
+long C8R_Run(C8_State *state, long cycles);
+
+//Returns 1 if both states have the same registers, stack, memory and display.
+static int statesMatch(C8_State *a, C8_State *b){
+    return a->pc == b->pc && a->i == b->i && a->sp == b->sp &&
+           memcmp(a->v, b->v, sizeof(a->v)) == 0 &&
+           a->delayTimer == b->delayTimer && a->soundTimer == b->soundTimer &&
+           memcmp(a->stack, b->stack, sizeof(uint16_t) * a->config->stackSize) == 0 &&
+           memcmp(a->memory, b->memory, a->config->memorySize) == 0 &&
+           memcmp(a->display, b->display,
+                  a->config->displayHeight * a->config->displayWidth) == 0;
+}
+#endif
+
+int main(int argc, char *argv[]){
+    long cycles = argc > 1 ? atol(argv[1]) : BENCH_CYCLES_DEFAULT;
+    C8_Config config;
+    C8_StandardConfig(&config);
+
+    C8_State *state = C8_CreateState(&config);
+    if (state == NULL){
+        fprintf(stderr, "%s\n", C8_GetError());
+        return 1;
+    }
+    C8_LoadFont(state, (uint8_t *)C8_FONT_STANDARD, C8_FONT_STANDARD_LEN);
+
+#ifdef C8_BENCH_RECOMPILED
+    int loaded = C8_LoadProgramBuffer(state, C8R_ROM, C8R_ROM_LEN);
+#else
+    int loaded = argc > 2 ? C8_LoadProgram(state, argv[2])
+                          : C8_LoadProgramBuffer(state, benchRom, sizeof(benchRom));
+#endif
+    if (!loaded){
+        fprintf(stderr, "%s\n", C8_GetError());
+        return 1;
+    }
+    clock_t start;
+
+#ifdef C8_BENCH_RECOMPILED
+    C8_State *recompiled = C8_CreateState(&config);
+    if (recompiled == NULL){
+        fprintf(stderr, "%s\n", C8_GetError());
+        return 1;
+    }
+    memcpy(recompiled->memory, state->memory, config.memorySize);
+
+    //Blocks run whole, so the interpreter then runs the same instruction count.
+    srand(1);
+    start = clock();
+    long executed = C8R_Run(recompiled, cycles);
+    double recompiledSeconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+    cycles = executed;
+    srand(1);
+#endif
+
+    start = clock();
+    for (long cycle = 0; cycle < cycles; cycle++)
+        C8_FDE(state);
+    double seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+#ifdef C8_BENCH_RECOMPILED
+    printf("recompiled: %ld cycles in %.3fs, %.1f million cycles/s, %s interpreter\n",
+           executed, recompiledSeconds, executed / recompiledSeconds / 1e6,
+           statesMatch(state, recompiled) ? "matches" : "DOES NOT MATCH");
+    C8_DestroyState(recompiled);
+#endif
+
+#ifdef C8_HARDENED
+    printf("hardened: ");
+#else
+    printf("unchecked: ");
+#endif
+    printf("%ld cycles in %.3fs, %.1f million cycles/s\n",
+           cycles, seconds, cycles / seconds / 1e6);
+
+    C8_DestroyState(state);
+    return 0;
+}
@@ -0,0 +1,433 @@
+#include "chip8_debug.h"
+#include "chip8_state.h"
+#include "chip8_error.h"
+#include "chip8_interpreter.h"
+#include <stdlib.h>
+#include <string.h>
+
+//Returns the breakpoint at address, or NULL.
+static C8_Breakpoint *findBreakpoint(C8_Debugger *debugger, uint16_t address){
+    for (int j = 0; j < debugger->breakpointCount; j++){
+        if (debugger->breakpoints[j].address == address)
+            return &(debugger->breakpoints[j]);
+    }
+    return NULL;
+}
+
+//Saves the instruction at the breakpoint and replaces it with a trap.
+static void patch(C8_Debugger *debugger, C8_Breakpoint *breakpoint){
+    uint8_t *memory = debugger->state->memory;
+
+    breakpoint->original = (memory[breakpoint->address] << 8) | memory[breakpoint->address + 1];
+    memory[breakpoint->address] = C8_TRAP_INSTRUCTION >> 8;
+    memory[breakpoint->address + 1] = C8_TRAP_INSTRUCTION & 0xFF;
+}
+
+/* Returns the instruction at the breakpoint as the program wrote it.
+ * Bytes of the trap the program has since overwritten are taken from memory. */
+static uint16_t programInstruction(C8_Debugger *debugger, C8_Breakpoint *breakpoint){
+    uint8_t *memory = debugger->state->memory;
+    uint16_t instruction = breakpoint->original;
+
+    if (memory[breakpoint->address] != C8_TRAP_INSTRUCTION >> 8)
+        instruction = (instruction & 0x00FF) | (memory[breakpoint->address] << 8);
+    if (memory[breakpoint->address + 1] != (C8_TRAP_INSTRUCTION & 0xFF))
+        instruction = (instruction & 0xFF00) | memory[breakpoint->address + 1];
+    return instruction;
+}
+
+//Restores the instruction at the breakpoint, keeping anything the program wrote over the trap.
+static void unpatch(C8_Debugger *debugger, C8_Breakpoint *breakpoint){
+    uint8_t *memory = debugger->state->memory;
+    uint16_t instruction = programInstruction(debugger, breakpoint);
+
+    memory[breakpoint->address] = instruction >> 8;
+    memory[breakpoint->address + 1] = instruction & 0xFF;
+}
+
+//Patches the breakpoint again if the program has overwritten its trap.
+static void rearm(C8_Debugger *debugger, C8_Breakpoint *breakpoint){
+    uint8_t *memory = debugger->state->memory;
+
+    if (memory[breakpoint->address] != C8_TRAP_INSTRUCTION >> 8 ||
+        memory[breakpoint->address + 1] != (C8_TRAP_INSTRUCTION & 0xFF)){
+        unpatch(debugger, breakpoint);
+        patch(debugger, breakpoint);
+    }
+}
+
+//Unpatches and removes the breakpoint.
+static void removeBreakpoint(C8_Debugger *debugger, C8_Breakpoint *breakpoint){
+    unpatch(debugger, breakpoint);
+    *breakpoint = debugger->breakpoints[--debugger->breakpointCount];
+}
+
+/* Returns the breakpoint at address, creating and patching it if needed.
+ * Returns NULL on fail. */
+static C8_Breakpoint *placeBreakpoint(C8_Debugger *debugger, uint16_t address){
+    C8_Breakpoint *breakpoint = findBreakpoint(debugger, address);
+    if (breakpoint != NULL)
+        return breakpoint;
+
+    if (address + 1 >= debugger->state->config->memorySize){
+        C8_SetError("Breakpoint address is outside of memory.");
+        return NULL;
+    }
+
+    if (debugger->breakpointCount >= C8_DEBUG_MAX_BREAKPOINTS){
+        C8_SetError("Too many breakpoints.");
+        return NULL;
+    }
+
+    breakpoint = &(debugger->breakpoints[debugger->breakpointCount++]);
+    memset(breakpoint, 0, sizeof(*breakpoint));
+    breakpoint->address = address;
+    patch(debugger, breakpoint);
+    return breakpoint;
+}
+
+//Removes breakpoints placed by step over and step out.
+static void clearTemporary(C8_Debugger *debugger){
+    for (int j = debugger->breakpointCount - 1; j >= 0; j--){
+        C8_Breakpoint *breakpoint = &(debugger->breakpoints[j]);
+        breakpoint->temporary = 0;
+        if (!breakpoint->user)
+            removeBreakpoint(debugger, breakpoint);
+    }
+}
+
+//Returns the instruction at address as the program wrote it.
+static uint16_t readInstruction(C8_Debugger *debugger, uint16_t address){
+    return (C8_DebugReadMemory(debugger, address) << 8) | C8_DebugReadMemory(debugger, address + 1);
+}
+
+//Called by C8_FDE on a trap. Steps PC back onto the breakpoint.
+static void trap(C8_State *state){
+    C8_Debugger *debugger = state->trapData;
+
+    //A trap instruction without a breakpoint is part of the program: 0NNN does nothing.
+    if (findBreakpoint(debugger, state->pc - 2) != NULL){
+        state->pc -= 2;
+        debugger->trapHit = 1;
+    }
+}
+
+//Returns the value of a C8_DebugAddCondition register.
+static uint16_t registerValue(C8_State *state, uint8_t reg){
+    switch (reg){
+        case C8_DEBUG_REGISTER_I:
+            return state->i;
+        case C8_DEBUG_REGISTER_DELAY:
+            return state->delayTimer;
+        case C8_DEBUG_REGISTER_SOUND:
+            return state->soundTimer;
+        default:
+            return state->v[reg];
+    }
+}
+
+/* Returns C8_DEBUG_STOP_WATCHPOINT if an instruction's access, from
+ * C8_InstructionMemoryAccess, falls in a watched range. */
+static uint8_t checkWatchpoints(C8_Debugger *debugger, int access, uint32_t address, uint16_t len){
+    if (access == C8_ACCESS_NONE)
+        return C8_DEBUG_STOP_NONE;
+
+    for (int j = 0; j < debugger->watchpointCount; j++){
+        C8_Watchpoint *watchpoint = &(debugger->watchpoints[j]);
+        if ((watchpoint->access & access) &&
+            address < (uint32_t)watchpoint->address + watchpoint->len &&
+            watchpoint->address < address + len){
+            debugger->stopAddress = address > watchpoint->address ? address : watchpoint->address;
+            return C8_DEBUG_STOP_WATCHPOINT;
+        }
+    }
+    return C8_DEBUG_STOP_NONE;
+}
+
+//Returns C8_DEBUG_STOP_CONDITION if any register condition was met by the last instruction.
+static uint8_t checkConditions(C8_Debugger *debugger){
+    uint8_t reason = C8_DEBUG_STOP_NONE;
+
+    for (int j = 0; j < debugger->conditionCount; j++){
+        C8_Condition *condition = &(debugger->conditions[j]);
+        uint16_t value = registerValue(debugger->state, condition->reg);
+
+        if (value != condition->last &&
+            (condition->kind == C8_DEBUG_CONDITION_CHANGE || value == condition->value))
+            reason = C8_DEBUG_STOP_CONDITION;
+        condition->last = value;
+    }
+    return reason;
+}
+
+/* Executes the instruction at PC as the program wrote it, stepping over any breakpoint.
+ * Breakpoints the instruction accesses are lifted while it runs, so it reads and writes
+ * the program's own bytes, and are patched again afterwards.
+ * Returns the watchpoint or condition stop reason it caused, or C8_DEBUG_STOP_NONE. */
+static uint8_t execute(C8_Debugger *debugger){
+    C8_State *state = debugger->state;
+    uint8_t lifted[C8_DEBUG_MAX_BREAKPOINTS];
+    uint8_t reason = C8_DEBUG_STOP_NONE;
+    uint32_t address;
+    uint16_t len;
+    int access = C8_InstructionMemoryAccess(state, readInstruction(debugger, state->pc),
+                                            &address, &len);
+
+    if (debugger->watchpointCount > 0)
+        reason = checkWatchpoints(debugger, access, address, len);
+
+    for (int j = 0; j < debugger->breakpointCount; j++){
+        C8_Breakpoint *breakpoint = &(debugger->breakpoints[j]);
+        lifted[j] = breakpoint->address == state->pc ||
+                    (access != C8_ACCESS_NONE && address < (uint32_t)breakpoint->address + 2 &&
+                     breakpoint->address < address + len);
+        if (lifted[j])
+            unpatch(debugger, breakpoint);
+    }
+
+    C8_FDE(state);
+
+    for (int j = 0; j < debugger->breakpointCount; j++){
+        if (lifted[j])
+            patch(debugger, &(debugger->breakpoints[j]));
+    }
+
+    if (debugger->conditionCount > 0 && checkConditions(debugger) != C8_DEBUG_STOP_NONE)
+        reason = C8_DEBUG_STOP_CONDITION;
+    return reason;
+}
+
+/* Returns the stop reason for reaching breakpoint, or C8_DEBUG_STOP_NONE
+ * if it is a temporary breakpoint for a different stack depth. */
+static uint8_t breakpointReason(C8_Debugger *debugger, C8_Breakpoint *breakpoint){
+    if (breakpoint == NULL)
+        return C8_DEBUG_STOP_NONE;
+
+    debugger->stopAddress = breakpoint->address;
+    if (breakpoint->user)
+        return C8_DEBUG_STOP_BREAKPOINT;
+    if (breakpoint->temporary && breakpoint->sp == debugger->state->sp)
+        return C8_DEBUG_STOP_STEP;
+    return C8_DEBUG_STOP_NONE;
+}
+
+/* Runs until a stop or until maxCycles instructions have executed.
+ * With no watchpoints or conditions, C8_FDE runs directly and only traps are noticed. */
+static uint8_t run(C8_Debugger *debugger, long maxCycles){
+    C8_State *state = debugger->state;
+    uint8_t reason = C8_DEBUG_STOP_NONE;
+    long cycle = 0;
+
+    //Leave the breakpoint we are stopped at rather than hitting it again.
+    if (maxCycles > 0 && findBreakpoint(debugger, state->pc) != NULL){
+        reason = execute(debugger);
+        cycle++;
+    }
+
+    while (reason == C8_DEBUG_STOP_NONE && cycle < maxCycles){
+        if (debugger->watchpointCount > 0 || debugger->conditionCount > 0){
+            reason = breakpointReason(debugger, findBreakpoint(debugger, state->pc));
+            if (reason == C8_DEBUG_STOP_NONE){
+                reason = execute(debugger);
+                cycle++;
+            }
+            continue;
+        }
+
+        debugger->trapHit = 0;
+        for (; cycle < maxCycles && !debugger->trapHit; cycle++)
+            C8_FDE(state);
+        if (!debugger->trapHit)
+            break;
+
+        cycle--; //The trap is not one of the program's instructions.
+        reason = breakpointReason(debugger, findBreakpoint(debugger, state->pc));
+        if (reason == C8_DEBUG_STOP_NONE){
+            reason = execute(debugger);
+            cycle++;
+        }
+    }
+
+    return reason;
+}
+
+/* Records reason as the debugger's stop reason and removes temporary breakpoints.
+ * Breakpoints the program overwrote while running unchecked are patched again. */
+static uint8_t stop(C8_Debugger *debugger, uint8_t reason){
+    clearTemporary(debugger);
+    for (int j = 0; j < debugger->breakpointCount; j++)
+        rearm(debugger, &(debugger->breakpoints[j]));
+    debugger->stopReason = reason;
+    return reason;
+}
+
+/* Attaches a debugger to state, using the state's trap function.
+ * Returns NULL on fail.
+ * Returned C8_Debugger should be freed with C8_DestroyDebugger. */
+C8_Debugger *C8_CreateDebugger(C8_State *state){
+    if (state == NULL){
+        C8_SetError("C8_CreateDebugger received NULL argument for state.");
+        return NULL;
+    }
+
+    if (state->trap != NULL){
+        C8_SetError("C8_CreateDebugger received a state which already has a trap function.");
+        return NULL;
+    }
+
+    C8_Debugger *debugger = calloc(1, sizeof(C8_Debugger));
+    if (debugger == NULL){
+        C8_SetError("C8_CreateDebugger could not allocate memory for C8_Debugger struct.");
+        return NULL;
+    }
+
+    debugger->state = state;
+    state->trap = trap;
+    state->trapData = debugger;
+    return debugger;
+}
+
+//Removes all breakpoints, detaches from the state and frees the debugger.
+void C8_DestroyDebugger(C8_Debugger *debugger){
+    while (debugger->breakpointCount > 0)
+        removeBreakpoint(debugger, &(debugger->breakpoints[0]));
+
+    debugger->state->trap = NULL;
+    debugger->state->trapData = NULL;
+    free(debugger);
+}
+
+//Sets a breakpoint on the instruction at address. Returns 1 on success, 0 on fail.
+int C8_DebugAddBreakpoint(C8_Debugger *debugger, uint16_t address){
+    C8_Breakpoint *breakpoint = placeBreakpoint(debugger, address);
+    if (breakpoint == NULL)
+        return 0;
+
+    breakpoint->user = 1;
+    return 1;
+}
+
+//Removes the breakpoint at address. Returns 1 on success, 0 if there is none.
+int C8_DebugRemoveBreakpoint(C8_Debugger *debugger, uint16_t address){
+    C8_Breakpoint *breakpoint = findBreakpoint(debugger, address);
+    if (breakpoint == NULL || !breakpoint->user){
+        C8_SetError("No breakpoint at address.");
+        return 0;
+    }
+
+    breakpoint->user = 0;
+    if (!breakpoint->temporary)
+        removeBreakpoint(debugger, breakpoint);
+    return 1;
+}
+
+/* Stops after any instruction which accesses [address, address + len) through i.
+ * access is C8_ACCESS_READ and/or C8_ACCESS_WRITE.
+ * Returns 1 on success, 0 on fail. */
+int C8_DebugAddWatchpoint(C8_Debugger *debugger, uint16_t address, uint16_t len, uint8_t access){
+    if (debugger->watchpointCount >= C8_DEBUG_MAX_WATCHPOINTS){
+        C8_SetError("Too many watchpoints.");
+        return 0;
+    }
+
+    C8_Watchpoint *watchpoint = &(debugger->watchpoints[debugger->watchpointCount++]);
+    watchpoint->address = address;
+    watchpoint->len = len;
+    watchpoint->access = access;
+    return 1;
+}
+
+void C8_DebugClearWatchpoints(C8_Debugger *debugger){
+    debugger->watchpointCount = 0;
+}
+
+/* Stops after any instruction which changes reg, or makes it equal to value.
+ * kind is a C8_DEBUG_CONDITION_* value. value is ignored for changes.
+ * Returns 1 on success, 0 on fail. */
+int C8_DebugAddCondition(C8_Debugger *debugger, uint8_t reg, uint8_t kind, uint16_t value){
+    if (reg > C8_DEBUG_REGISTER_SOUND){
+        C8_SetError("Unknown condition register.");
+        return 0;
+    }
+
+    if (debugger->conditionCount >= C8_DEBUG_MAX_CONDITIONS){
+        C8_SetError("Too many conditions.");
+        return 0;
+    }
+
+    C8_Condition *condition = &(debugger->conditions[debugger->conditionCount++]);
+    condition->reg = reg;
+    condition->kind = kind;
+    condition->value = value;
+    condition->last = registerValue(debugger->state, reg);
+    return 1;
+}
+
+void C8_DebugClearConditions(C8_Debugger *debugger){
+    debugger->conditionCount = 0;
+}
+
+/* Returns the byte at address as the program wrote it, hiding breakpoint patches.
+ * Returns 0 for addresses outside of memory. */
+uint8_t C8_DebugReadMemory(C8_Debugger *debugger, uint16_t address){
+    if (address >= debugger->state->config->memorySize)
+        return 0;
+
+    C8_Breakpoint *breakpoint = findBreakpoint(debugger, address);
+    if (breakpoint != NULL)
+        return programInstruction(debugger, breakpoint) >> 8;
+
+    breakpoint = findBreakpoint(debugger, address - 1);
+    if (breakpoint != NULL)
+        return programInstruction(debugger, breakpoint) & 0xFF;
+
+    return debugger->state->memory[address];
+}
+
+//Executes one instruction.
+uint8_t C8_DebugStep(C8_Debugger *debugger){
+    uint8_t reason = execute(debugger);
+    return stop(debugger, reason == C8_DEBUG_STOP_NONE ? C8_DEBUG_STOP_STEP : reason);
+}
+
+/* Executes one instruction, running a called subroutine (2NNN) until it returns.
+ * Stops early on breakpoints, watchpoints and conditions, or after maxCycles. */
+uint8_t C8_DebugStepOver(C8_Debugger *debugger, long maxCycles){
+    C8_State *state = debugger->state;
+
+    if ((readInstruction(debugger, state->pc) & 0xF000) != 0x2000)
+        return C8_DebugStep(debugger);
+
+    C8_Breakpoint *breakpoint = placeBreakpoint(debugger, state->pc + 2);
+    if (breakpoint == NULL)
+        return stop(debugger, C8_DEBUG_STOP_ERROR);
+    breakpoint->temporary = 1;
+    breakpoint->sp = state->sp;
+
+    return stop(debugger, run(debugger, maxCycles));
+}
+
+/* Runs until the current subroutine returns (00EE) to its caller.
+ * Stops early on breakpoints, watchpoints and conditions, or after maxCycles. */
+uint8_t C8_DebugStepOut(C8_Debugger *debugger, long maxCycles){
+    C8_State *state = debugger->state;
+
+    if (state->sp == 0){
+        C8_SetError("Cannot step out: not in a subroutine.");
+        return stop(debugger, C8_DEBUG_STOP_ERROR);
+    }
+
+    uint16_t returnAddress = state->stack[C8_STACK_INDEX(state, state->sp - 1)];
+    C8_Breakpoint *breakpoint = placeBreakpoint(debugger, returnAddress);
+    if (breakpoint == NULL)
+        return stop(debugger, C8_DEBUG_STOP_ERROR);
+    breakpoint->temporary = 1;
+    breakpoint->sp = state->sp - 1;
+
+    return stop(debugger, run(debugger, maxCycles));
+}
+
+//Runs until a breakpoint, watchpoint or condition stops it, or for maxCycles.
+uint8_t C8_DebugContinue(C8_Debugger *debugger, long maxCycles){
+    return stop(debugger, run(debugger, maxCycles));
+}
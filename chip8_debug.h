@@ -0,0 +1,82 @@
+#ifndef CHIP8_DEBUG_H_GUARD
+#define CHIP8_DEBUG_H_GUARD
+
+#include "chip8_state.h"
+
+#define C8_DEBUG_MAX_BREAKPOINTS 64
+#define C8_DEBUG_MAX_WATCHPOINTS 16
+#define C8_DEBUG_MAX_CONDITIONS 16
+
+//Reasons returned by C8_DebugStep, C8_DebugContinue etc.
+#define C8_DEBUG_STOP_NONE 0x0 //Cycle budget ran out.
+#define C8_DEBUG_STOP_BREAKPOINT 0x1 //PC reached a breakpoint.
+#define C8_DEBUG_STOP_WATCHPOINT 0x2 //An instruction accessed a watched range.
+#define C8_DEBUG_STOP_CONDITION 0x3 //A register condition was met.
+#define C8_DEBUG_STOP_STEP 0x4 //Step, step over or step out finished.
+#define C8_DEBUG_STOP_ERROR 0x5 //Request could not be carried out. See C8_GetError.
+
+//C8_DebugAddCondition registers. 0x0 to 0xF are V0 to VF.
+#define C8_DEBUG_REGISTER_I 0x10
+#define C8_DEBUG_REGISTER_DELAY 0x11
+#define C8_DEBUG_REGISTER_SOUND 0x12
+
+//C8_DebugAddCondition kinds.
+#define C8_DEBUG_CONDITION_CHANGE 0x1 //Register changes value.
+#define C8_DEBUG_CONDITION_EQUAL 0x2 //Register becomes equal to value.
+
+typedef struct C8_Breakpoint{
+    uint16_t address; //Address of patched instruction.
+    uint16_t original; //Instruction replaced by C8_TRAP_INSTRUCTION.
+    uint8_t user; //Set by C8_DebugAddBreakpoint.
+    uint8_t temporary; //Set by step over and step out. Only hits at stack depth sp.
+    uint8_t sp; //Stack depth for temporary breakpoints.
+} C8_Breakpoint;
+
+typedef struct C8_Watchpoint{
+    uint16_t address; //Start of watched range.
+    uint16_t len; //Length of watched range.
+    uint8_t access; //C8_ACCESS_READ and/or C8_ACCESS_WRITE.
+} C8_Watchpoint;
+
+typedef struct C8_Condition{
+    uint8_t reg; //V0 to VF, or C8_DEBUG_REGISTER_* value.
+    uint8_t kind; //C8_DEBUG_CONDITION_* value.
+    uint16_t value; //Value to become equal to.
+    uint16_t last; //Register's value when last checked.
+} C8_Condition;
+
+/* Debugger attached to a C8_State.
+ * Breakpoints are patched into memory as C8_TRAP_INSTRUCTION, so running with
+ * only breakpoints set costs the same as running without the debugger.
+ * Watchpoints and conditions are checked every instruction while any are set,
+ * and breakpoints an instruction accesses are lifted while it runs.
+ * Without them, ROMs reading their own code will see the patched instructions,
+ * and a ROM writing over a breakpoint disarms it until the run stops. */
+typedef struct C8_Debugger{
+    C8_State *state; //Debugged state.
+    C8_Breakpoint breakpoints[C8_DEBUG_MAX_BREAKPOINTS];
+    uint8_t breakpointCount;
+    C8_Watchpoint watchpoints[C8_DEBUG_MAX_WATCHPOINTS];
+    uint8_t watchpointCount;
+    C8_Condition conditions[C8_DEBUG_MAX_CONDITIONS];
+    uint8_t conditionCount;
+    uint8_t trapHit; //Set by the trap function when a breakpoint is reached.
+    uint8_t stopReason; //Reason for last stop.
+    uint16_t stopAddress; //Address of breakpoint or watched access which caused the stop.
+} C8_Debugger;
+
+C8_Debugger *C8_CreateDebugger(C8_State *state);
+void C8_DestroyDebugger(C8_Debugger *debugger);
+int C8_DebugAddBreakpoint(C8_Debugger *debugger, uint16_t address);
+int C8_DebugRemoveBreakpoint(C8_Debugger *debugger, uint16_t address);
+int C8_DebugAddWatchpoint(C8_Debugger *debugger, uint16_t address, uint16_t len, uint8_t access);
+void C8_DebugClearWatchpoints(C8_Debugger *debugger);
+int C8_DebugAddCondition(C8_Debugger *debugger, uint8_t reg, uint8_t kind, uint16_t value);
+void C8_DebugClearConditions(C8_Debugger *debugger);
+uint8_t C8_DebugReadMemory(C8_Debugger *debugger, uint16_t address);
+uint8_t C8_DebugStep(C8_Debugger *debugger);
+uint8_t C8_DebugStepOver(C8_Debugger *debugger, long maxCycles);
+uint8_t C8_DebugStepOut(C8_Debugger *debugger, long maxCycles);
+uint8_t C8_DebugContinue(C8_Debugger *debugger, long maxCycles);
+
+#endif
@@ -0,0 +1,186 @@
+#include "chip8_debug.h"
+#include "chip8_state.h"
+#include "chip8_error.h"
+#include "chip8_interpreter.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Headless debugger front end. Reads one command per line from stdin,
+ * so it can also be driven over a local socket, e.g. with socat.
+ * Usage: c8dbg <rom path>
+ * Addresses and values are hexadecimal. Type h for commands. */
+
+#define CLI_LINE_LEN 128
+#define CLI_CYCLES_DEFAULT 1000000 //Budget for c, n and f without a cycle count.
+
+static const char *help =
+    "b ADDR               set breakpoint\n"
+    "d ADDR               delete breakpoint\n"
+    "w ADDR LEN [r|w|rw]  watch memory range (default rw)\n"
+    "W                    clear watchpoints\n"
+    "r REG change         stop when REG (v0-vf, i, dt, st) changes\n"
+    "r REG = VALUE        stop when REG becomes VALUE\n"
+    "R                    clear register conditions\n"
+    "c [CYCLES]           continue\n"
+    "s                    step\n"
+    "n [CYCLES]           step over\n"
+    "f [CYCLES]           step out\n"
+    "k KEY                set pressed key (ff for none)\n"
+    "p                    print registers\n"
+    "x ADDR [LEN]         dump memory\n"
+    "q                    quit\n";
+
+static const char *reasons[] = {"cycle budget used", "breakpoint", "watchpoint",
+                                "condition", "step", "error"};
+
+//Parses a register name. Returns 0xFF if unknown.
+static uint8_t parseRegister(const char *name){
+    if ((name[0] == 'v' || name[0] == 'V') && name[1] != '\0' && name[2] == '\0')
+        return (uint8_t)strtoul(&name[1], NULL, 16);
+    if (strcmp(name, "i") == 0)
+        return C8_DEBUG_REGISTER_I;
+    if (strcmp(name, "dt") == 0)
+        return C8_DEBUG_REGISTER_DELAY;
+    if (strcmp(name, "st") == 0)
+        return C8_DEBUG_REGISTER_SOUND;
+    return 0xFF;
+}
+
+static void printRegisters(C8_Debugger *debugger){
+    C8_State *state = debugger->state;
+
+    printf("pc=%03x [%02x%02x] i=%03x sp=%u dt=%02x st=%02x\n", state->pc,
+           C8_DebugReadMemory(debugger, state->pc), C8_DebugReadMemory(debugger, state->pc + 1),
+           state->i, state->sp, state->delayTimer, state->soundTimer);
+    for (int j = 0; j < CHIP8_STATE_V_COUNT; j++)
+        printf("v%x=%02x%c", j, state->v[j], j == CHIP8_STATE_V_COUNT - 1 ? '\n' : ' ');
+}
+
+static void printStop(C8_Debugger *debugger, uint8_t reason){
+    if (reason == C8_DEBUG_STOP_ERROR){
+        printf("error: %s\n", C8_GetError());
+        return;
+    }
+
+    printf("stopped: %s", reasons[reason]);
+    if (reason == C8_DEBUG_STOP_WATCHPOINT || reason == C8_DEBUG_STOP_BREAKPOINT)
+        printf(" at %03x", debugger->stopAddress);
+    printf("\n");
+    printRegisters(debugger);
+}
+
+//Executes a command line. Returns 0 to quit.
+static int command(C8_Debugger *debugger, char *line){
+    char name[16] = "", arg1[16] = "", arg2[16] = "", arg3[16] = "";
+    int argc = sscanf(line, "%15s %15s %15s %15s", name, arg1, arg2, arg3);
+    long cycles = argc > 1 ? strtol(arg1, NULL, 10) : CLI_CYCLES_DEFAULT;
+    uint16_t address = (uint16_t)strtoul(arg1, NULL, 16);
+    int ok = 1;
+
+    if (argc <= 0)
+        return 1;
+
+    switch (name[0]){
+        case 'b':
+            ok = argc > 1 && C8_DebugAddBreakpoint(debugger, address);
+            break;
+        case 'd':
+            ok = argc > 1 && C8_DebugRemoveBreakpoint(debugger, address);
+            break;
+        case 'w': {
+            uint8_t access = C8_ACCESS_READ | C8_ACCESS_WRITE;
+            if (strcmp(arg3, "r") == 0)
+                access = C8_ACCESS_READ;
+            else if (strcmp(arg3, "w") == 0)
+                access = C8_ACCESS_WRITE;
+            ok = argc > 2 && C8_DebugAddWatchpoint(debugger, address,
+                                                   (uint16_t)strtoul(arg2, NULL, 16), access);
+            break;
+        }
+        case 'W':
+            C8_DebugClearWatchpoints(debugger);
+            break;
+        case 'r':
+            if (argc > 2 && strcmp(arg2, "change") == 0)
+                ok = C8_DebugAddCondition(debugger, parseRegister(arg1),
+                                          C8_DEBUG_CONDITION_CHANGE, 0);
+            else if (argc > 3 && strcmp(arg2, "=") == 0)
+                ok = C8_DebugAddCondition(debugger, parseRegister(arg1), C8_DEBUG_CONDITION_EQUAL,
+                                          (uint16_t)strtoul(arg3, NULL, 16));
+            else
+                ok = 0;
+            break;
+        case 'R':
+            C8_DebugClearConditions(debugger);
+            break;
+        case 'c':
+            printStop(debugger, C8_DebugContinue(debugger, cycles));
+            break;
+        case 's':
+            printStop(debugger, C8_DebugStep(debugger));
+            break;
+        case 'n':
+            printStop(debugger, C8_DebugStepOver(debugger, cycles));
+            break;
+        case 'f':
+            printStop(debugger, C8_DebugStepOut(debugger, cycles));
+            break;
+        case 'k':
+            debugger->state->key = (uint8_t)strtoul(arg1, NULL, 16);
+            break;
+        case 'p':
+            printRegisters(debugger);
+            break;
+        case 'x': {
+            uint16_t len = argc > 2 ? (uint16_t)strtoul(arg2, NULL, 16) : 16;
+            for (uint16_t j = 0; j < len && address + j < debugger->state->config->memorySize; j++)
+                printf("%s%02x", j % 16 == 0 ? (j ? "\n" : "") : " ",
+                       C8_DebugReadMemory(debugger, address + j));
+            printf("\n");
+            break;
+        }
+        case 'q':
+            return 0;
+        default:
+            printf("%s", help);
+            break;
+    }
+
+    if (!ok)
+        printf("error: %s\n", C8_GetError());
+    fflush(stdout);
+    return 1;
+}
+
+int main(int argc, char *argv[]){
+    char line[CLI_LINE_LEN];
+    C8_Config config;
+    C8_StandardConfig(&config);
+
+    if (argc < 2){
+        fprintf(stderr, "usage: %s <rom path>\n", argv[0]);
+        return 1;
+    }
+
+    C8_State *state = C8_CreateState(&config);
+    if (state == NULL || !C8_LoadProgram(state, argv[1])){
+        fprintf(stderr, "%s\n", C8_GetError());
+        return 1;
+    }
+    C8_LoadFont(state, (uint8_t *)C8_FONT_STANDARD, C8_FONT_STANDARD_LEN);
+
+    C8_Debugger *debugger = C8_CreateDebugger(state);
+    if (debugger == NULL){
+        fprintf(stderr, "%s\n", C8_GetError());
+        return 1;
+    }
+
+    printRegisters(debugger);
+    fflush(stdout);
+    while (fgets(line, sizeof(line), stdin) != NULL && command(debugger, line));
+
+    C8_DestroyDebugger(debugger);
+    C8_DestroyState(state);
+    return 0;
+}
@@ -0,0 +1,280 @@
+#include "chip8_fuzz.h"
+#include "chip8_state.h"
+#include "chip8_error.h"
+#include "chip8_interpreter.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+/* Fuzzing harness for the interpreter and for ROMs.
+ * Build with C8_FUZZ_LIBFUZZER for a libFuzzer entry point,
+ * or with C8_FUZZ_AFL for an AFL main reading the ROM from stdin.
+ * Findings are checked BEFORE the offending instruction executes,
+ * so out of range accesses never actually happen. */
+
+//Marks the pages covering [address, address + len) as dirty.
+static void markDirty(C8_FuzzContext *context, uint32_t address, uint32_t len){
+    if (len == 0)
+        return;
+
+    for (uint32_t page = address / C8_FUZZ_PAGE_SIZE;
+     page <= (address + len - 1) / C8_FUZZ_PAGE_SIZE && page < context->pageCount;
+     page++){
+        if (!context->dirty[page]){
+            context->dirty[page] = 1;
+            context->dirtyPages[context->dirtyCount++] = page;
+        }
+    }
+}
+
+//Records the edge from the previous PC to pc, AFL style.
+static void recordEdge(C8_FuzzContext *context, uint16_t pc){
+    uint16_t location = (uint16_t)(pc * 0x9E37); //Spread nearby PCs across the map.
+
+    context->coverage[(location ^ context->previousLocation) % C8_FUZZ_MAP_SIZE]++;
+    context->previousLocation = location >> 1;
+}
+
+//Records a finding and its cause. Returns the finding.
+static uint8_t report(C8_FuzzContext *context, uint8_t finding, uint16_t pc,
+                      uint16_t instruction, const char *description){
+    char message[128];
+
+    context->findings |= finding;
+    context->findingPc = pc;
+    context->findingInstruction = instruction;
+    snprintf(message, sizeof(message), "%s: instruction %04x at %03x.",
+             description, instruction, pc);
+    C8_SetError(message);
+    return finding;
+}
+
+/* Checks the instruction at pc for findings before it is executed.
+ * Tracks the memory and display it will dirty.
+ * Returns the finding, or C8_FUZZ_FINDING_NONE. */
+static uint8_t check(C8_FuzzContext *context, uint16_t pc, uint16_t instruction){
+    C8_State *state = context->state;
+    uint32_t address;
+    uint16_t len;
+    int access;
+
+    if (instruction == 0x00EE && state->sp == 0)
+        return report(context, C8_FUZZ_FINDING_STACK_UNDERFLOW, pc, instruction,
+                      "Stack underflow");
+
+    if ((instruction & 0xF000) == 0x2000 && state->sp >= state->config->stackSize)
+        return report(context, C8_FUZZ_FINDING_STACK_OVERFLOW, pc, instruction,
+                      "Stack overflow");
+
+    if (instruction == 0x00E0 || (instruction & 0xF000) == 0xD000)
+        context->displayDirty = 1;
+
+    access = C8_InstructionMemoryAccess(state, instruction, &address, &len);
+    if (access == C8_ACCESS_NONE)
+        return C8_FUZZ_FINDING_NONE;
+
+    if (address + len > state->config->memorySize){
+        if (access == C8_ACCESS_WRITE)
+            return report(context, C8_FUZZ_FINDING_MEMORY_WRITE, pc, instruction,
+                          "Out of range memory write");
+        return report(context, C8_FUZZ_FINDING_MEMORY_READ, pc, instruction,
+                      "Out of range memory read");
+    }
+
+    if (access == C8_ACCESS_WRITE)
+        markDirty(context, address, len);
+
+    return C8_FUZZ_FINDING_NONE;
+}
+
+/* Creates a fuzzing context with a state configured by config.
+ * The standard font is loaded into the state.
+ * coverage must point to C8_FUZZ_MAP_SIZE bytes, and may be shared with the fuzzer.
+ * Returns NULL on fail.
+ * Returned C8_FuzzContext should be freed with C8_DestroyFuzzContext. */
+C8_FuzzContext *C8_CreateFuzzContext(C8_Config *config, uint8_t *coverage, uint32_t cycleBudget){
+    if (config == NULL || coverage == NULL){
+        C8_SetError("C8_CreateFuzzContext received NULL argument.");
+        return NULL;
+    }
+
+    C8_FuzzContext *context = calloc(1, sizeof(C8_FuzzContext));
+    if (context == NULL){
+        C8_SetError("C8_CreateFuzzContext could not allocate memory for C8_FuzzContext struct.");
+        return NULL;
+    }
+
+    context->state = C8_CreateState(config);
+    if (context->state == NULL){
+        free(context);
+        return NULL;
+    }
+    C8_LoadFont(context->state, (uint8_t *)C8_FONT_STANDARD, C8_FONT_STANDARD_LEN);
+
+    context->pageCount = (config->memorySize + C8_FUZZ_PAGE_SIZE - 1) / C8_FUZZ_PAGE_SIZE;
+    context->pristine = malloc(sizeof(uint8_t) * config->memorySize);
+    context->dirty = calloc(context->pageCount, sizeof(uint8_t));
+    context->dirtyPages = malloc(sizeof(uint16_t) * context->pageCount);
+    if (context->pristine == NULL || context->dirty == NULL || context->dirtyPages == NULL){
+        C8_SetError("C8_CreateFuzzContext could not allocate memory for page tracking.");
+        C8_DestroyFuzzContext(context);
+        return NULL;
+    }
+
+    memcpy(context->pristine, context->state->memory, sizeof(uint8_t) * config->memorySize);
+    context->coverage = coverage;
+    context->cycleBudget = cycleBudget;
+
+    return context;
+}
+
+/* Frees the given C8_FuzzContext and its state.
+ * The coverage bitmap belongs to the caller and is not freed. */
+void C8_DestroyFuzzContext(C8_FuzzContext *context){
+    if (context->state != NULL)
+        C8_DestroyState(context->state);
+    free(context->pristine);
+    free(context->dirty);
+    free(context->dirtyPages);
+    free(context);
+}
+
+/* Returns the context's state to how it was after C8_CreateFuzzContext.
+ * Only dirtied memory pages are restored. */
+void C8_FuzzReset(C8_FuzzContext *context){
+    C8_State *state = context->state;
+
+    for (uint16_t j = 0; j < context->dirtyCount; j++){
+        uint32_t start = context->dirtyPages[j] * C8_FUZZ_PAGE_SIZE;
+        uint32_t len = C8_FUZZ_PAGE_SIZE;
+        if (start + len > state->config->memorySize)
+            len = state->config->memorySize - start;
+
+        memcpy(&(state->memory[start]), &(context->pristine[start]), len);
+        context->dirty[context->dirtyPages[j]] = 0;
+    }
+    context->dirtyCount = 0;
+
+    if (context->displayDirty){
+        memset(state->display, 0,
+               sizeof(uint8_t) * state->config->displayHeight * state->config->displayWidth);
+        context->displayDirty = 0;
+    }
+
+    memset(state->stack, 0, sizeof(uint16_t) * state->config->stackSize);
+    state->pc = state->config->programAddress;
+    state->i = 0;
+    state->sp = 0;
+    memset(state->v, 0, sizeof(state->v));
+    state->delayTimer = 0;
+    state->soundTimer = 0;
+    state->key = CHIP8_STATE_NULL_KEY;
+
+    context->previousLocation = 0;
+    context->findings = C8_FUZZ_FINDING_NONE;
+    srand(0); //CXNN must be deterministic for inputs to reproduce.
+}
+
+/* Resets the context, loads rom and runs it for the context's cycle budget,
+ * or until PC runs off the end of memory. Most ROMs which do not loop end that way,
+ * so it is not a finding.
+ * Edge coverage is recorded into the context's coverage bitmap.
+ * Returns the findings flags. On a finding, the error string describes it. */
+uint8_t C8_FuzzRun(C8_FuzzContext *context, const uint8_t *rom, size_t len){
+    C8_State *state = context->state;
+
+    C8_FuzzReset(context);
+    if (!C8_LoadProgramBuffer(state, rom, len))
+        return C8_FUZZ_FINDING_NONE; //Too big to be a ROM; not interesting.
+    markDirty(context, state->config->programAddress, len);
+
+    for (uint32_t cycle = 0; cycle < context->cycleBudget; cycle++){
+        uint16_t pc = state->pc;
+        if (pc + 1 >= state->config->memorySize)
+            break;
+
+        uint16_t instruction = (state->memory[pc] << 8) | state->memory[pc + 1];
+        recordEdge(context, pc);
+        if (check(context, pc, instruction) != C8_FUZZ_FINDING_NONE)
+            return context->findings;
+
+        C8_FDE(state);
+    }
+
+    return context->findings;
+}
+
+#if defined(C8_FUZZ_LIBFUZZER) || defined(C8_FUZZ_AFL)
+//Creates the context used by the fuzzer entry points.
+static C8_FuzzContext *createStandardContext(uint8_t *coverage){
+    C8_Config config;
+    C8_StandardConfig(&config);
+
+    C8_FuzzContext *context = C8_CreateFuzzContext(&config, coverage, C8_FUZZ_CYCLE_BUDGET);
+    if (context == NULL){
+        fprintf(stderr, "%s\n", C8_GetError());
+        abort();
+    }
+    return context;
+}
+
+//Crashes on findings so the fuzzer saves the input.
+static void fuzzOne(C8_FuzzContext *context, const uint8_t *data, size_t size){
+    if (C8_FuzzRun(context, data, size) != C8_FUZZ_FINDING_NONE){
+        fprintf(stderr, "%s\n", C8_GetError());
+        abort();
+    }
+}
+#endif
+
+#ifdef C8_FUZZ_LIBFUZZER
+//libFuzzer picks up CHIP-8 edge coverage from its extra counters section.
+__attribute__((section("__libfuzzer_extra_counters")))
+static uint8_t libFuzzerCoverage[C8_FUZZ_MAP_SIZE];
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size){
+    static C8_FuzzContext *context = NULL;
+
+    if (context == NULL)
+        context = createStandardContext(libFuzzerCoverage);
+    fuzzOne(context, data, size);
+    return 0;
+}
+#endif
+
+#ifdef C8_FUZZ_AFL
+#include <sys/shm.h>
+#include <unistd.h>
+
+#ifndef __AFL_LOOP
+#define __AFL_LOOP(count) (aflOnce++ == 0) //Not afl-clang-fast; one input per process.
+static int aflOnce = 0;
+#endif
+
+//Reads a ROM from stdin. CHIP-8 edges go straight into AFL's shared bitmap.
+int main(void){
+    static uint8_t localCoverage[C8_FUZZ_MAP_SIZE];
+    static uint8_t rom[C8_MEMORY_SIZE_STANDARD];
+    uint8_t *coverage = localCoverage;
+    char *shmId = getenv("__AFL_SHM_ID");
+
+    if (shmId != NULL){
+        void *shm = shmat(atoi(shmId), NULL, 0);
+        if (shm != (void *)-1)
+            coverage = shm;
+    }
+
+    C8_FuzzContext *context = createStandardContext(coverage);
+    while (__AFL_LOOP(10000)){
+        //read, not fread: stdin's EOF flag would stick and hide later inputs.
+        size_t len = 0;
+        ssize_t got;
+        while (len < sizeof(rom) && (got = read(0, &(rom[len]), sizeof(rom) - len)) > 0)
+            len += got;
+        fuzzOne(context, rom, len);
+    }
+
+    C8_DestroyFuzzContext(context);
+    return 0;
+}
+#endif
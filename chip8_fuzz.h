@@ -0,0 +1,45 @@
+#ifndef CHIP8_FUZZ_H_GUARD
+#define CHIP8_FUZZ_H_GUARD
+
+#include "chip8_state.h"
+#include <stddef.h>
+
+#define C8_FUZZ_MAP_SIZE 65536 //Size of coverage bitmap in bytes. Matches AFL's default.
+#define C8_FUZZ_PAGE_SIZE 256 //Granularity of memory restored between iterations.
+#define C8_FUZZ_CYCLE_BUDGET 100000 //Default cycles run per input.
+
+//C8_FuzzRun findings flags.
+#define C8_FUZZ_FINDING_NONE 0x0
+/* Instruction would read memory outside of memorySize (DXYN, FX65). */
+#define C8_FUZZ_FINDING_MEMORY_READ 0x1
+/* Instruction would write memory outside of memorySize (FX33, FX55). */
+#define C8_FUZZ_FINDING_MEMORY_WRITE 0x2
+/* 2NNN called with a full stack. */
+#define C8_FUZZ_FINDING_STACK_OVERFLOW 0x4
+/* 00EE returned with an empty stack. */
+#define C8_FUZZ_FINDING_STACK_UNDERFLOW 0x8
+
+/* Runs ROMs from byte buffers against one reusable C8_State.
+ * Only memory pages dirtied by an iteration are restored before the next. */
+typedef struct C8_FuzzContext{
+    C8_State *state; //Reused for every iteration.
+    uint8_t *pristine; //Memory image restored between iterations.
+    uint8_t *dirty; //Per-page dirty flags.
+    uint16_t *dirtyPages; //Indices of dirty pages.
+    uint16_t dirtyCount; //Number of entries in dirtyPages.
+    uint16_t pageCount; //Number of pages in memory.
+    uint8_t displayDirty; //Set when display has been drawn to.
+    uint8_t *coverage; //Edge coverage bitmap of CHIP-8 PCs, C8_FUZZ_MAP_SIZE bytes.
+    uint16_t previousLocation; //Previous PC hash, for edge coverage.
+    uint32_t cycleBudget; //Cycles run per input.
+    uint8_t findings; //Findings flags of the last run.
+    uint16_t findingPc; //Address of the instruction which caused the finding.
+    uint16_t findingInstruction; //Instruction which caused the finding.
+} C8_FuzzContext;
+
+C8_FuzzContext *C8_CreateFuzzContext(C8_Config *config, uint8_t *coverage, uint32_t cycleBudget);
+void C8_DestroyFuzzContext(C8_FuzzContext *context);
+void C8_FuzzReset(C8_FuzzContext *context);
+uint8_t C8_FuzzRun(C8_FuzzContext *context, const uint8_t *rom, size_t len);
+
+#endif
@@ -28,7 +28,7 @@ void C8_00E0(C8_State *state){
 //Return from subroutine.
 void C8_00EE(C8_State *state){
     state->sp--;
-    state->pc = state->stack[state->sp];
+    state->pc = state->stack[C8_STACK_INDEX(state, state->sp)];
 }
 
 //Jump to memory address NNN.
@@ -38,7 +38,7 @@ void C8_1NNN(C8_State *state, uint16_t NNN){
 
 //Subroutine at NNN.
 void C8_2NNN(C8_State *state, uint16_t NNN){
-    state->stack[state->sp] = state->pc;
+    state->stack[C8_STACK_INDEX(state, state->sp)] = state->pc;
     state->sp++;
     state->pc = NNN;
 
@@ -176,7 +176,7 @@ void C8_DXYN(C8_State *state, uint8_t X, uint8_t Y, uint8_t N){
     for (int spriteRow = 0; 
      spriteRow < N && spriteRow + ystart < state->config->displayHeight;
      spriteRow++){
-        uint8_t spriteByte = state->memory[state->i + spriteRow];
+        uint8_t spriteByte = state->memory[C8_ADDRESS(state, state->i + spriteRow)];
         for (int spriteCol = 0;
          spriteCol < 8 && spriteCol + xstart < state->config->displayWidth;
          spriteCol++){
@@ -240,7 +240,6 @@ void C8_FX1E(C8_State *state, uint8_t X){
 
 //Get key and store in VX. Blocking. User specifies actual key getting function.
 void C8_FX0A(C8_State *state, uint8_t X){
-    printf("here");
     if (state->config->instructionMode & C8_CONFIG_KEYPRESS_USE_GIVEN_KEY)
         state->v[X] = state->key;
     else if (state->config->instructionMode & C8_CONFIG_KEYPRESS_GET_KEY){
@@ -259,13 +258,13 @@ void C8_FX29(C8_State* state, uint8_t X){
 void C8_FX33(C8_State* state, uint8_t X){
     uint8_t buffer = state->v[X];
 
-    state->memory[state->i] = buffer / 100;
+    state->memory[C8_ADDRESS(state, state->i)] = buffer / 100;
     buffer %= 100;
 
-    state->memory[state->i + 1] = buffer / 10;
+    state->memory[C8_ADDRESS(state, state->i + 1)] = buffer / 10;
     buffer %= 10;
 
-    state->memory[state->i + 2] = buffer;
+    state->memory[C8_ADDRESS(state, state->i + 2)] = buffer;
 }
 
 //Write registers v0 to vx into memory starting at i.
@@ -273,7 +272,7 @@ void C8_FX55(C8_State *state, uint8_t X){
     uint8_t j;
 
     for (j = 0; j <= X; j++){
-        state->memory[state->i + j] = state->v[j];
+        state->memory[C8_ADDRESS(state, state->i + j)] = state->v[j];
     }
 
     if (state->config->instructionMode & C8_CONFIG_INSTRUCTION_FX55_FX65_INC_I)
@@ -285,7 +284,7 @@ void C8_FX65(C8_State *state, uint8_t X){
     uint8_t j;
 
     for (j = 0; j <= X; j++){
-        state->v[j] = state->memory[state->i + j];
+        state->v[j] = state->memory[C8_ADDRESS(state, state->i + j)];
     }
 
     if (state->config->instructionMode & C8_CONFIG_INSTRUCTION_FX55_FX65_INC_I)
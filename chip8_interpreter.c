@@ -1,6 +1,7 @@
 #include "chip8_state.h"
 #include "chip8_error.h"
 #include "chip8_instructions.h"
+#include "chip8_interpreter.h"
 #include <stdio.h>
 #include <stdint.h>
 #include <string.h>
@@ -21,29 +22,185 @@ int C8_LoadProgram(C8_State *state, char *path){
         }
         state->memory[address] = (uint8_t)byte;
         address++;
-        printf("%u %x\n", address, byte);
     }
 
     fclose(file);
     return 1;
 }
 
+/* Loads a program from a byte buffer instead of a file.
+ * Returns 1 on success, 0 on fail. */
+int C8_LoadProgramBuffer(C8_State *state, const uint8_t *buffer, size_t len){
+    if (buffer == NULL && len > 0){
+        C8_SetError("C8_LoadProgramBuffer received NULL argument for buffer.");
+        return 0;
+    }
+
+    if (state->config->programAddress + len > state->config->memorySize){
+        C8_SetError("Program is too big to load into memory.");
+        return 0;
+    }
+
+    memcpy(&(state->memory[state->config->programAddress]), buffer, len);
+    return 1;
+}
+
 int C8_LoadFont(C8_State *state, uint8_t *font, uint8_t fontLen){
     memcpy(&(state->memory[state->config->fontAddress]), font, fontLen);
     return 1;
 }
 
+/* Finds the range of memory the given instruction will access through i,
+ * using the state's current registers.
+ * Sets address and len to the range's start and length.
+ * Returns C8_ACCESS_READ or C8_ACCESS_WRITE, or C8_ACCESS_NONE
+ * if the instruction does not access memory through i. */
+int C8_InstructionMemoryAccess(C8_State *state, uint16_t instruction,
+                               uint32_t *address, uint16_t *len){
+    uint8_t xnibble = (instruction >> 8) & 0x0F;
+    uint16_t rows;
+
+    *address = state->i;
+    *len = 0;
+
+    switch (instruction & 0xF0FF){
+        case 0xF033:
+            *len = 3; //BCD of vx.
+            return C8_ACCESS_WRITE;
+        case 0xF055:
+            *len = xnibble + 1; //v0 to vx.
+            return C8_ACCESS_WRITE;
+        case 0xF065:
+            *len = xnibble + 1; //v0 to vx.
+            return C8_ACCESS_READ;
+    }
+
+    if ((instruction & 0xF000) == 0xD000){
+        //Rows which fall off the bottom of the display are never read.
+        rows = state->config->displayHeight -
+               state->v[(instruction >> 4) & 0x0F] % state->config->displayHeight;
+        *len = (instruction & 0x0F) < rows ? (instruction & 0x0F) : rows;
+        return *len > 0 ? C8_ACCESS_READ : C8_ACCESS_NONE;
+    }
+
+    return C8_ACCESS_NONE;
+}
+
+/* Names and operands of each opcode's handler in chip8_instructions.h,
+ * for tools which generate calls to them. */
+const C8_OpcodeInfo C8_OPCODE_INFO[C8_OP_COUNT] = {
+    [C8_OP_UNKNOWN] = {NULL, C8_OPERANDS_NONE},
+    [C8_OP_0NNN] = {"0NNN", C8_OPERANDS_NONE},
+    [C8_OP_00E0] = {"00E0", C8_OPERANDS_STATE},
+    [C8_OP_00EE] = {"00EE", C8_OPERANDS_STATE},
+    [C8_OP_1NNN] = {"1NNN", C8_OPERANDS_NNN},
+    [C8_OP_2NNN] = {"2NNN", C8_OPERANDS_NNN},
+    [C8_OP_3XNN] = {"3XNN", C8_OPERANDS_XNN},
+    [C8_OP_4XNN] = {"4XNN", C8_OPERANDS_XNN},
+    [C8_OP_5XY0] = {"5XY0", C8_OPERANDS_XY},
+    [C8_OP_6XNN] = {"6XNN", C8_OPERANDS_XNN},
+    [C8_OP_7XNN] = {"7XNN", C8_OPERANDS_XNN},
+    [C8_OP_8XY0] = {"8XY0", C8_OPERANDS_XY},
+    [C8_OP_8XY1] = {"8XY1", C8_OPERANDS_XY},
+    [C8_OP_8XY2] = {"8XY2", C8_OPERANDS_XY},
+    [C8_OP_8XY3] = {"8XY3", C8_OPERANDS_XY},
+    [C8_OP_8XY4] = {"8XY4", C8_OPERANDS_XY},
+    [C8_OP_8XY5] = {"8XY5", C8_OPERANDS_XY},
+    [C8_OP_8XY6] = {"8XY6", C8_OPERANDS_XY},
+    [C8_OP_8XY7] = {"8XY7", C8_OPERANDS_XY},
+    [C8_OP_8XYE] = {"8XYE", C8_OPERANDS_XY},
+    [C8_OP_9XY0] = {"9XY0", C8_OPERANDS_XY},
+    [C8_OP_ANNN] = {"ANNN", C8_OPERANDS_NNN},
+    [C8_OP_BNNN] = {"BNNN", C8_OPERANDS_NNN},
+    [C8_OP_CXNN] = {"CXNN", C8_OPERANDS_XNN},
+    [C8_OP_DXYN] = {"DXYN", C8_OPERANDS_XYN},
+    [C8_OP_EX9E] = {"EX9E", C8_OPERANDS_X},
+    [C8_OP_EXA1] = {"EXA1", C8_OPERANDS_X},
+    [C8_OP_FX07] = {"FX07", C8_OPERANDS_X},
+    [C8_OP_FX0A] = {"FX0A", C8_OPERANDS_X},
+    [C8_OP_FX15] = {"FX15", C8_OPERANDS_X},
+    [C8_OP_FX18] = {"FX18", C8_OPERANDS_X},
+    [C8_OP_FX1E] = {"FX1E", C8_OPERANDS_X},
+    [C8_OP_FX29] = {"FX29", C8_OPERANDS_X},
+    [C8_OP_FX33] = {"FX33", C8_OPERANDS_X},
+    [C8_OP_FX55] = {"FX55", C8_OPERANDS_X},
+    [C8_OP_FX65] = {"FX65", C8_OPERANDS_X}
+};
+
+//Decodes instruction to its handler's opcode. Static so C8_FDE can inline it.
+static inline C8_Opcode decode(uint16_t instruction){
+    switch (instruction >> 12){
+        case 0x0:
+            switch (instruction){
+                case 0x00E0: return C8_OP_00E0; //clear screen.
+                case 0x00EE: return C8_OP_00EE; //return from subroutine.
+                default: return C8_OP_0NNN; //does nothing.
+            }
+        case 0x1: return C8_OP_1NNN; //jump to NNN.
+        case 0x2: return C8_OP_2NNN; //call subroutine NNN.
+        case 0x3: return C8_OP_3XNN; //skip next if vx == nn.
+        case 0x4: return C8_OP_4XNN; //skip next if vx != nn.
+        case 0x5: return C8_OP_5XY0; //skip next if vx == vy.
+        case 0x6: return C8_OP_6XNN; //sets vx = nn.
+        case 0x7: return C8_OP_7XNN; //adds nn to vx w-out carry.
+        case 0x8:
+            switch (instruction & 0x0F){
+                case 0x0: return C8_OP_8XY0; //vx = vy.
+                case 0x1: return C8_OP_8XY1; //vx |= vy.
+                case 0x2: return C8_OP_8XY2; //vx &= vy.
+                case 0x3: return C8_OP_8XY3; //vx ^= vy.
+                case 0x4: return C8_OP_8XY4; //vx += vy. vf = overflow.
+                case 0x5: return C8_OP_8XY5; //vx -= vy. vf != overflow.
+                case 0x6: return C8_OP_8XY6; //vx = vy >> 1. vf = overflow. Configurable.
+                case 0x7: return C8_OP_8XY7; //vx = vy - vx. vf != overflow.
+                case 0xE: return C8_OP_8XYE; //vx = vy << 1. vf = overflow. Configurable.
+                default: return C8_OP_UNKNOWN;
+            }
+        case 0x9: return C8_OP_9XY0; //skip next if vx != vy.
+        case 0xA: return C8_OP_ANNN; //sets I to NNN.
+        case 0xB: return C8_OP_BNNN; //jump with offset. Configurable.
+        case 0xC: return C8_OP_CXNN; //vx = random & nn.
+        case 0xD: return C8_OP_DXYN; //draw sprite to buffer.
+        case 0xE:
+            switch (instruction & 0xFF){
+                case 0x9E: return C8_OP_EX9E; //skip if key == vx.
+                case 0xA1: return C8_OP_EXA1; //skip if key != vx.
+                default: return C8_OP_UNKNOWN;
+            }
+        case 0xF:
+            switch (instruction & 0xFF){
+                case 0x07: return C8_OP_FX07; //vx = delay timer.
+                case 0x0A: return C8_OP_FX0A; //get key (block).
+                case 0x15: return C8_OP_FX15; //delay timer = vx.
+                case 0x18: return C8_OP_FX18; //sound timer = vx.
+                case 0x1E: return C8_OP_FX1E; //i += vx.
+                case 0x29: return C8_OP_FX29; //i = loc of character vx.
+                case 0x33: return C8_OP_FX33; //store BCD of vx starting at i.
+                case 0x55: return C8_OP_FX55; //store registers v0 to vx in memory starting at i.
+                case 0x65: return C8_OP_FX65; //load registers v0 to vx in memory starting at i.
+                default: return C8_OP_UNKNOWN;
+            }
+    }
+    return C8_OP_UNKNOWN;
+}
+
+/* Returns the opcode of the handler which executes instruction,
+ * or C8_OP_UNKNOWN if it is unrecognised.
+ * C8_FDE and the recompiler both decode through this. */
+C8_Opcode C8_DecodeInstruction(uint16_t instruction){
+    return decode(instruction);
+}
+
 //Performs a single fetch decode execute cycle.
 void C8_FDE(C8_State *state){
     //fetch - Instructions occupy 2 bytes, big endian style.
     uint16_t instruction;
-    instruction = state->memory[state->pc];
+    instruction = state->memory[C8_ADDRESS(state, state->pc)];
     instruction = instruction << 8;
-    instruction += state->memory[state->pc+1];
+    instruction += state->memory[C8_ADDRESS(state, state->pc+1)];
     state->pc += 2;
 
     //Decode - Split the instruction.
-    uint8_t msnibble = instruction >> 12; 
     uint8_t xnibble = (instruction >> 8) & 0x0F;
     uint8_t ynibble = (instruction >> 4) & 0x0F;
     uint8_t nnibble = instruction & 0x0F;
@@ -51,181 +208,47 @@ void C8_FDE(C8_State *state){
     uint16_t nnnaddress = instruction & 0x0FFF;
 
     //Execute - Switch to function representing instruction and run.
-    switch (msnibble){
-        case 0x0:
-            switch (instruction){
-                case 0x00E0:
-                    C8_00E0(state); //clear screen.
-                    break;
-                case 0x00EE:
-                    C8_00EE(state);
-                    break;
-                default:
-                    C8_0NNN(); //does nothing.
-                    break;
-            }
-            break;
-
-        case 0x1:
-            C8_1NNN(state, nnnaddress); //jump to NNN.
-            break; 
-
-        case 0x2:
-            C8_2NNN(state, nnnaddress); //call subroutine NNN.
-            break;
-
-        case 0x3:
-            C8_3XNN(state, xnibble, nnbyte); //skip next if vx == nn.
-            break;
-
-        case 0x4:
-            C8_4XNN(state, xnibble, nnbyte); //skip next if vx != nn.
-            break;
-
-        case 0x5:
-            C8_5XY0(state, xnibble, ynibble); //skip next if vx == vy.
-            break;
-
-        case 0x6:
-            C8_6XNN(state, xnibble, nnbyte); //sets vx = nn.
-            break;
-
-        case 0x7:
-            C8_7XNN(state, xnibble, nnbyte); //adds nn to vx w-out carry.
-            break;
-
-        case 0x8:
-            switch (nnibble){
-                case 0:
-                    C8_8XY0(state, xnibble, ynibble); //vx = vy.
-                    break;
-
-                case 1:
-                    C8_8XY1(state, xnibble, ynibble); //vx |= vy.
-                    break;
-
-                case 2:
-                    C8_8XY2(state, xnibble, ynibble); //vx &= vy.
-                    break;
-
-                case 3:
-                    C8_8XY3(state, xnibble, ynibble); //vx ^= vy.
-                    break;
-
-                case 4:
-                    C8_8XY4(state, xnibble, ynibble); //vx += vy. vf = overflow.
-                    break;
-
-                case 5:
-                    C8_8XY5(state, xnibble, ynibble); //vx -= vy. vf != overflow.
-                    break;
-
-                case 6:
-                    //configurable behaviour. C8_CONFIG_SHIFT_VY.
-                    C8_8XY6(state, xnibble, ynibble); //vx = vy >> 1. vf = overflow.
-                    break;
-
-                case 7:
-                    C8_8XY7(state, xnibble, ynibble); //vx = vy - vx. vf != overflow.
-                    break;
-
-                case 0xE:
-                    //configurable behaviour. C8_CONFIG_SHIFT_VY.
-                    C8_8XYE(state, xnibble, ynibble); //vx = vy << 1. vf = overflow.
-                    break;
-
-                default:
-                    #ifdef C8_WARNINGS
-                        printf("warning: unrecognised 8-series instruction %x", instruction); 
-                    #endif
-                    break;
-            }
-            break;
-
-        case 0x9:
-            C8_9XY0(state, xnibble, ynibble); //skip next if vx != vy.
-            break;
-
-        case 0xA:
-            C8_ANNN(state, nnnaddress); //sets I to NNN.
-            break;
-
-        case 0xB:
-            //Configurable behaviour - C8_CONFIG_JUMP_XNN.
-            C8_BNNN(state, nnnaddress); //jump with offset.
-            break;
-
-        case 0xC:
-            C8_CXNN(state, xnibble, nnbyte);
-            break;
-
-        case 0xD:
-            C8_DXYN(state, xnibble, ynibble, nnibble); //draw sprite to buffer.
-            break;
-
-        case 0xE:
-            switch (nnbyte){
-                case 0x9E:
-                    C8_EX9E(state, xnibble);
-                    break;
-                case 0xA1:
-                    C8_EXA1(state, xnibble);
-                    break;
-                default:
-                #ifdef C8_WARNINGS
-                    printf("Encountered unrecognised instruction %x at %x",
-                    instruction, state->pc - 2);
-                #endif
-                    break;
-            }
-            break;
-
-        case 0xF:
-            switch (nnbyte){
-                case 0x07:
-                    C8_FX07(state, xnibble); //vx = delay timer.
-                    break;
-
-                case 0x0A:
-                    C8_FX0A(state, xnibble); //get key (block).
-                    break;
-                
-                case 0x15:
-                    C8_FX15(state, xnibble); //delay timer = vx.
-                    break;
-
-                case 0x18:
-                    C8_FX18(state, xnibble); //sound timer = vx.
-                    break;
-
-                case 0x1E:
-                    C8_FX1E(state, xnibble); //i += vx.
-                    break;
-
-                case 0x29:
-                    C8_FX29(state, xnibble); //i = loc of character vx.
-                    break;
-
-                case 0x33:
-                    C8_FX33(state, xnibble); //store BCD of vx starting at i.
-                    break;
-
-                case 0x55:
-                    C8_FX55(state, xnibble); //store registers v0 to vx in memory starting at i.
-                    break;
-
-                case 0x65:
-                    C8_FX65(state, xnibble); //load registers v0 to vx in memory starting at i.
-                    break;
-
-                default:
-                    #ifdef C8_WARNINGS
-                        printf("Encountered unrecognised instruction %x at %x",
-                        instruction, state->pc - 2);
-                    #endif
-                    break;
-            }
+    switch (decode(instruction)){
+        case C8_OP_0NNN:
+            C8_0NNN();
+            //Breakpoints are patched in as traps, so cost nothing elsewhere.
+            if (instruction == C8_TRAP_INSTRUCTION && state->trap != NULL)
+                state->trap(state);
             break;
+        case C8_OP_00E0: C8_00E0(state); break;
+        case C8_OP_00EE: C8_00EE(state); break;
+        case C8_OP_1NNN: C8_1NNN(state, nnnaddress); break;
+        case C8_OP_2NNN: C8_2NNN(state, nnnaddress); break;
+        case C8_OP_3XNN: C8_3XNN(state, xnibble, nnbyte); break;
+        case C8_OP_4XNN: C8_4XNN(state, xnibble, nnbyte); break;
+        case C8_OP_5XY0: C8_5XY0(state, xnibble, ynibble); break;
+        case C8_OP_6XNN: C8_6XNN(state, xnibble, nnbyte); break;
+        case C8_OP_7XNN: C8_7XNN(state, xnibble, nnbyte); break;
+        case C8_OP_8XY0: C8_8XY0(state, xnibble, ynibble); break;
+        case C8_OP_8XY1: C8_8XY1(state, xnibble, ynibble); break;
+        case C8_OP_8XY2: C8_8XY2(state, xnibble, ynibble); break;
+        case C8_OP_8XY3: C8_8XY3(state, xnibble, ynibble); break;
+        case C8_OP_8XY4: C8_8XY4(state, xnibble, ynibble); break;
+        case C8_OP_8XY5: C8_8XY5(state, xnibble, ynibble); break;
+        case C8_OP_8XY6: C8_8XY6(state, xnibble, ynibble); break;
+        case C8_OP_8XY7: C8_8XY7(state, xnibble, ynibble); break;
+        case C8_OP_8XYE: C8_8XYE(state, xnibble, ynibble); break;
+        case C8_OP_9XY0: C8_9XY0(state, xnibble, ynibble); break;
+        case C8_OP_ANNN: C8_ANNN(state, nnnaddress); break;
+        case C8_OP_BNNN: C8_BNNN(state, nnnaddress); break;
+        case C8_OP_CXNN: C8_CXNN(state, xnibble, nnbyte); break;
+        case C8_OP_DXYN: C8_DXYN(state, xnibble, ynibble, nnibble); break;
+        case C8_OP_EX9E: C8_EX9E(state, xnibble); break;
+        case C8_OP_EXA1: C8_EXA1(state, xnibble); break;
+        case C8_OP_FX07: C8_FX07(state, xnibble); break;
+        case C8_OP_FX0A: C8_FX0A(state, xnibble); break;
+        case C8_OP_FX15: C8_FX15(state, xnibble); break;
+        case C8_OP_FX18: C8_FX18(state, xnibble); break;
+        case C8_OP_FX1E: C8_FX1E(state, xnibble); break;
+        case C8_OP_FX29: C8_FX29(state, xnibble); break;
+        case C8_OP_FX33: C8_FX33(state, xnibble); break;
+        case C8_OP_FX55: C8_FX55(state, xnibble); break;
+        case C8_OP_FX65: C8_FX65(state, xnibble); break;
 
         default:
             #ifdef C8_WARNINGS
@@ -234,4 +257,4 @@ void C8_FDE(C8_State *state){
             #endif
             break;
     }
-}
\ No newline at end of file
+}
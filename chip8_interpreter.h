@@ -1,9 +1,52 @@
 #ifndef CHIP8_INTERPRETER_H_GUARD
 #define CHIP8_INTERPRETER_H_GUARD
 #include "chip8_state.h"
+#include <stddef.h>
+
+/* 0NNN instruction which calls the parent C8_State's trap function.
+ * Patched over instructions by the debugger to place breakpoints. */
+#define C8_TRAP_INSTRUCTION 0x0FFF
+
+//C8_InstructionMemoryAccess return values.
+#define C8_ACCESS_NONE 0x0
+#define C8_ACCESS_READ 0x1
+#define C8_ACCESS_WRITE 0x2
+
+//C8_DecodeInstruction opcodes. One per handler in chip8_instructions.h.
+typedef enum C8_Opcode{
+    C8_OP_UNKNOWN,
+    C8_OP_0NNN, C8_OP_00E0, C8_OP_00EE, C8_OP_1NNN, C8_OP_2NNN,
+    C8_OP_3XNN, C8_OP_4XNN, C8_OP_5XY0, C8_OP_6XNN, C8_OP_7XNN,
+    C8_OP_8XY0, C8_OP_8XY1, C8_OP_8XY2, C8_OP_8XY3, C8_OP_8XY4,
+    C8_OP_8XY5, C8_OP_8XY6, C8_OP_8XY7, C8_OP_8XYE, C8_OP_9XY0,
+    C8_OP_ANNN, C8_OP_BNNN, C8_OP_CXNN, C8_OP_DXYN, C8_OP_EX9E,
+    C8_OP_EXA1, C8_OP_FX07, C8_OP_FX0A, C8_OP_FX15, C8_OP_FX18,
+    C8_OP_FX1E, C8_OP_FX29, C8_OP_FX33, C8_OP_FX55, C8_OP_FX65,
+    C8_OP_COUNT
+} C8_Opcode;
+
+//C8_OpcodeInfo operands. Arguments the handler takes after state.
+#define C8_OPERANDS_NONE 0x0 //No arguments at all, not even state.
+#define C8_OPERANDS_STATE 0x1 //state only.
+#define C8_OPERANDS_NNN 0x2 //NNN.
+#define C8_OPERANDS_X 0x3 //X.
+#define C8_OPERANDS_XNN 0x4 //X, NN.
+#define C8_OPERANDS_XY 0x5 //X, Y.
+#define C8_OPERANDS_XYN 0x6 //X, Y, N.
+
+typedef struct C8_OpcodeInfo{
+    const char *name; //Handler name without the C8_ prefix. NULL for C8_OP_UNKNOWN.
+    uint8_t operands; //C8_OPERANDS_* value.
+} C8_OpcodeInfo;
+
+extern const C8_OpcodeInfo C8_OPCODE_INFO[C8_OP_COUNT];
 
 int C8_LoadProgram(C8_State *state, char *path);
+int C8_LoadProgramBuffer(C8_State *state, const uint8_t *buffer, size_t len);
 int C8_LoadFont(C8_State *state, uint8_t *font, uint8_t fontLen);
+int C8_InstructionMemoryAccess(C8_State *state, uint16_t instruction,
+                               uint32_t *address, uint16_t *len);
+C8_Opcode C8_DecodeInstruction(uint16_t instruction);
 void C8_FDE(C8_State *state);
 
 #endif
\ No newline at end of file
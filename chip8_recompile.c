@@ -0,0 +1,321 @@
+#include "chip8_state.h"
+#include "chip8_interpreter.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Ahead of time recompiler. Translates a ROM into a C file with one label per basic block,
+ * each calling the chip8_instructions.c handlers directly.
+ * Usage: c8rc <rom path> <output path> [name]
+ * The output defines:
+ *   const uint8_t <name>_ROM[], const size_t <name>_ROM_LEN - the ROM, for loading.
+ *   long <name>_Run(C8_State *state, long cycles) - runs for at least cycles instructions
+ *   unless a block is in progress, and returns the number executed.
+ * Code reached only dynamically (00EE, BNNN) is dispatched by PC. PCs with no block, and
+ * blocks overwritten by the program, fall back to C8_FDE. Blocks assume the ROM is loaded
+ * at C8_PROGRAM_ADDRESS_STANDARD. */
+
+#define RECOMPILE_ADDRESS C8_PROGRAM_ADDRESS_STANDARD
+#define RECOMPILE_NAME_DEFAULT "C8R"
+
+static uint8_t rom[C8_MEMORY_SIZE_STANDARD];
+static uint16_t romEnd; //First address after the ROM.
+static uint8_t leader[C8_MEMORY_SIZE_STANDARD + 2]; //Set for addresses starting a block.
+static uint8_t visited[C8_MEMORY_SIZE_STANDARD + 2]; //Set for addresses decoded as instructions.
+
+//Instruction kinds, for finding blocks.
+#define KIND_PLAIN 0 //Continues to the next instruction.
+#define KIND_JUMP 1 //1NNN.
+#define KIND_CALL 2 //2NNN.
+#define KIND_SKIP 3 //May skip the next instruction.
+#define KIND_DYNAMIC 4 //Target only known at run time: 00EE, BNNN, traps.
+#define KIND_WRITE 5 //Writes memory through i: FX33, FX55.
+
+//Returns 1 if a whole instruction at address lies in the ROM.
+static int inRom(uint32_t address){
+    return address >= RECOMPILE_ADDRESS && address + 1 < romEnd;
+}
+
+static uint16_t fetch(uint16_t address){
+    return (rom[address] << 8) | rom[address + 1];
+}
+
+/* Classifies an instruction, decoding it with C8_DecodeInstruction as C8_FDE does.
+ * Writes a call to its handler into call, assuming the variable state. */
+static int decode(uint16_t instruction, char *call, size_t len){
+    C8_Opcode opcode = C8_DecodeInstruction(instruction);
+    const C8_OpcodeInfo *info = &C8_OPCODE_INFO[opcode];
+    uint8_t xnibble = (instruction >> 8) & 0x0F;
+    uint8_t ynibble = (instruction >> 4) & 0x0F;
+    uint8_t nnibble = instruction & 0x0F;
+    uint8_t nnbyte = instruction & 0xFF;
+    uint16_t nnnaddress = instruction & 0x0FFF;
+
+    call[0] = '\0';
+    if (instruction == C8_TRAP_INSTRUCTION){
+        snprintf(call, len, "C8_0NNN(); if (state->trap != NULL) state->trap(state);");
+        return KIND_DYNAMIC;
+    }
+
+    if (info->name != NULL){
+        switch (info->operands){
+            case C8_OPERANDS_NONE:
+                snprintf(call, len, "C8_%s();", info->name);
+                break;
+            case C8_OPERANDS_STATE:
+                snprintf(call, len, "C8_%s(state);", info->name);
+                break;
+            case C8_OPERANDS_NNN:
+                snprintf(call, len, "C8_%s(state, 0x%03x);", info->name, nnnaddress);
+                break;
+            case C8_OPERANDS_X:
+                snprintf(call, len, "C8_%s(state, 0x%x);", info->name, xnibble);
+                break;
+            case C8_OPERANDS_XNN:
+                snprintf(call, len, "C8_%s(state, 0x%x, 0x%02x);", info->name, xnibble, nnbyte);
+                break;
+            case C8_OPERANDS_XY:
+                snprintf(call, len, "C8_%s(state, 0x%x, 0x%x);", info->name, xnibble, ynibble);
+                break;
+            case C8_OPERANDS_XYN:
+                snprintf(call, len, "C8_%s(state, 0x%x, 0x%x, 0x%x);",
+                         info->name, xnibble, ynibble, nnibble);
+                break;
+        }
+    }
+
+    switch (opcode){
+        case C8_OP_1NNN:
+            return KIND_JUMP;
+        case C8_OP_2NNN:
+            return KIND_CALL;
+        case C8_OP_3XNN: case C8_OP_4XNN: case C8_OP_5XY0:
+        case C8_OP_9XY0: case C8_OP_EX9E: case C8_OP_EXA1:
+            return KIND_SKIP;
+        case C8_OP_00EE: case C8_OP_BNNN:
+            return KIND_DYNAMIC;
+        case C8_OP_FX33: case C8_OP_FX55:
+            return KIND_WRITE;
+        default:
+            return KIND_PLAIN;
+    }
+}
+
+//Marks address as a block start, if it can be recompiled.
+static void addLeader(uint16_t address, uint16_t *worklist, int *count){
+    if (inRom(address) && !leader[address]){
+        leader[address] = 1;
+        worklist[(*count)++] = address;
+    }
+}
+
+//Finds every block reachable from the program address through static control flow.
+static void findBlocks(void){
+    static uint16_t worklist[C8_MEMORY_SIZE_STANDARD];
+    char call[96];
+    int count = 0;
+
+    addLeader(RECOMPILE_ADDRESS, worklist, &count);
+    while (count > 0){
+        uint16_t address = worklist[--count];
+
+        while (inRom(address) && !visited[address]){
+            uint16_t instruction = fetch(address);
+            int kind = decode(instruction, call, sizeof(call));
+            visited[address] = 1;
+
+            if (kind == KIND_JUMP){
+                addLeader(instruction & 0x0FFF, worklist, &count);
+                break;
+            } else if (kind == KIND_CALL){
+                addLeader(instruction & 0x0FFF, worklist, &count);
+                addLeader(address + 2, worklist, &count); //00EE returns here.
+                break;
+            } else if (kind == KIND_SKIP){
+                addLeader(address + 2, worklist, &count);
+                addLeader(address + 4, worklist, &count);
+                break;
+            } else if (kind == KIND_DYNAMIC){
+                break;
+            }
+            address += 2;
+        }
+    }
+}
+
+//Writes a transfer to the block at target, with PC already set.
+static void emitChain(FILE *out, uint16_t target){
+    if (inRom(target) && leader[target])
+        fprintf(out, "    C8R_CHAIN(L_%03x);\n", target);
+    else
+        fprintf(out, "    goto dispatch;\n");
+}
+
+//Writes the block starting at start. Returns the address after its last instruction.
+static uint16_t emitBlock(FILE *out, uint16_t start){
+    char call[96];
+    uint16_t address = start;
+
+    fprintf(out, "L_%03x:\n", start);
+    while (inRom(address)){
+        uint16_t instruction = fetch(address);
+        int kind = decode(instruction, call, sizeof(call));
+
+        fprintf(out, "    executed++;\n");
+        //Handlers which read or change PC expect it to already be incremented.
+        if (kind != KIND_PLAIN && kind != KIND_WRITE)
+            fprintf(out, "    state->pc = 0x%03x;\n", address + 2);
+        else if (C8_DecodeInstruction(instruction) == C8_OP_FX0A)
+            fprintf(out, "    state->pc = 0x%03x;\n", address + 2);
+
+        if (kind == KIND_WRITE){
+            //i is read before the handler, which may increment it.
+            fprintf(out, "    {\n        uint32_t written = C8_ADDRESS(state, state->i);\n");
+            fprintf(out, "        %s /* %03x: %04x */\n", call, address, instruction);
+            fprintf(out, "        if (C8R_WRITES_CODE(written, %u)){ modified = 1; state->pc = 0x%03x; goto dispatch; }\n    }\n",
+                    (instruction & 0xFF) == 0x33 ? 3 : ((instruction >> 8) & 0x0F) + 1,
+                    address + 2);
+        } else {
+            fprintf(out, "    %s /* %03x: %04x */\n", call, address, instruction);
+        }
+
+        switch (kind){
+            case KIND_JUMP:
+            case KIND_CALL:
+                emitChain(out, instruction & 0x0FFF);
+                return address + 2;
+            case KIND_SKIP:
+                fprintf(out, "    if (state->pc == 0x%03x){\n    ", address + 4);
+                emitChain(out, address + 4);
+                fprintf(out, "    }\n");
+                emitChain(out, address + 2);
+                return address + 2;
+            case KIND_DYNAMIC:
+                fprintf(out, "    goto dispatch;\n");
+                return address + 2;
+        }
+
+        address += 2;
+        if (leader[address])
+            break;
+    }
+
+    fprintf(out, "    state->pc = 0x%03x;\n", address);
+    emitChain(out, address);
+    return address;
+}
+
+int main(int argc, char *argv[]){
+    if (argc < 3){
+        fprintf(stderr, "usage: %s <rom path> <output path> [name]\n", argv[0]);
+        return 1;
+    }
+    const char *name = argc > 3 ? argv[3] : RECOMPILE_NAME_DEFAULT;
+
+    FILE *file = fopen(argv[1], "rb");
+    if (file == NULL){
+        fprintf(stderr, "Could not open program file.\n");
+        return 1;
+    }
+    size_t romLen = fread(&rom[RECOMPILE_ADDRESS], 1, sizeof(rom) - RECOMPILE_ADDRESS, file);
+    fclose(file);
+    romEnd = RECOMPILE_ADDRESS + romLen;
+
+    findBlocks();
+
+    //Bounds of recompiled code, for spotting self modification.
+    uint16_t codeStart = romEnd, codeEnd = RECOMPILE_ADDRESS;
+    for (uint16_t address = RECOMPILE_ADDRESS; address < romEnd; address++){
+        if (visited[address]){
+            codeStart = address < codeStart ? address : codeStart;
+            codeEnd = address + 2 > codeEnd ? address + 2 : codeEnd;
+        }
+    }
+    if (codeStart > codeEnd)
+        codeStart = codeEnd;
+
+    FILE *out = fopen(argv[2], "w");
+    if (out == NULL){
+        fprintf(stderr, "Could not open output file.\n");
+        return 1;
+    }
+
+    fprintf(out, "/* Recompiled from %s by c8rc. Do not edit. */\n", argv[1]);
+    fprintf(out, "#include \"chip8_state.h\"\n#include \"chip8_instructions.h\"\n"
+                 "#include \"chip8_interpreter.h\"\n#include <stddef.h>\n#include <string.h>\n\n");
+
+    fprintf(out, "const size_t %s_ROM_LEN = %zu;\nconst uint8_t %s_ROM[] = {", name, romLen, name);
+    for (size_t j = 0; j < romLen; j++)
+        fprintf(out, "%s0x%02x,", j % 16 == 0 ? "\n    " : " ", rom[RECOMPILE_ADDRESS + j]);
+    fprintf(out, "\n};\n\n");
+
+    fprintf(out, "#define C8R_CODE_START 0x%03x\n#define C8R_CODE_END 0x%03x\n", codeStart, codeEnd);
+    fprintf(out, "//True if a write of len bytes at address touches recompiled code.\n"
+                 "#define C8R_WRITES_CODE(address, len) ((address) < C8R_CODE_END && \\\n"
+                 "                                       (address) + (len) > C8R_CODE_START)\n");
+    fprintf(out, "//True if the block at address no longer matches the ROM.\n"
+                 "#define C8R_CHANGED(address, len) (memcmp(&state->memory[address], \\\n"
+                 "                                  &%s_ROM[(address) - 0x%03x], len) != 0)\n",
+            name, RECOMPILE_ADDRESS);
+    fprintf(out, "//Transfers straight to a block unless out of cycles or code was modified.\n"
+                 "#define C8R_CHAIN(label) if (executed < cycles && !modified) goto label; goto dispatch\n\n");
+
+    //Without blocks there is nothing to check for modification, only the interpreter loop.
+    int blocks = 0;
+    for (uint16_t address = RECOMPILE_ADDRESS; address < romEnd; address++)
+        blocks += leader[address];
+
+    if (blocks > 0){
+        fprintf(out, "//True if the instruction at PC will write into recompiled code.\n"
+                     "static int interpretedWritesCode(C8_State *state){\n"
+                     "    uint16_t instruction = (state->memory[C8_ADDRESS(state, state->pc)] << 8) |\n"
+                     "                           state->memory[C8_ADDRESS(state, state->pc + 1)];\n"
+                     "    uint32_t address;\n    uint16_t len;\n\n"
+                     "    return C8_InstructionMemoryAccess(state, instruction, &address, &len) == C8_ACCESS_WRITE &&\n"
+                     "           C8R_WRITES_CODE(C8_ADDRESS(state, address), len);\n}\n\n");
+    }
+
+    fprintf(out, "long %s_Run(C8_State *state, long cycles){\n", name);
+    fprintf(out, "    long executed = 0;\n");
+    if (blocks > 0)
+        fprintf(out, "    int modified = C8R_CHANGED(C8R_CODE_START, C8R_CODE_END - C8R_CODE_START);\n");
+    fprintf(out, "\ndispatch:\n    if (executed >= cycles)\n        return executed;\n\n");
+
+    if (blocks > 0){
+        fprintf(out, "    switch (state->pc){\n");
+
+        //Dispatch table, with the block's length for checking modification.
+        for (uint16_t address = RECOMPILE_ADDRESS; address < romEnd; address++){
+            if (!leader[address])
+                continue;
+            uint16_t end = address;
+            while (inRom(end)){
+                char call[96];
+                int kind = decode(fetch(end), call, sizeof(call));
+                end += 2;
+                if (kind == KIND_JUMP || kind == KIND_CALL || kind == KIND_SKIP ||
+                    kind == KIND_DYNAMIC || leader[end])
+                    break;
+            }
+            fprintf(out, "        case 0x%03x: if (modified && C8R_CHANGED(0x%03x, %u)) break; goto L_%03x;\n",
+                    address, address, end - address, address);
+        }
+        fprintf(out, "    }\n\n");
+
+        //Code reached only by the interpreter may still overwrite blocks.
+        fprintf(out, "    //Not recompiled, or overwritten: interpret.\n"
+                     "    if (interpretedWritesCode(state))\n        modified = 1;\n");
+    }
+    fprintf(out, "    C8_FDE(state);\n    executed++;\n    goto dispatch;\n\n");
+
+    for (uint16_t address = RECOMPILE_ADDRESS; address < romEnd; address++){
+        if (leader[address]){
+            emitBlock(out, address);
+            fprintf(out, "\n");
+        }
+    }
+    fprintf(out, "}\n");
+
+    fclose(out);
+    return 0;
+}
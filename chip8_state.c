@@ -4,6 +4,35 @@
 #include <string.h>
 #include <stdio.h>
 
+//Returns the smallest power of two >= n.
+static uint32_t roundPow2(uint32_t n){
+    uint32_t pow2 = 1;
+    while (pow2 < n)
+        pow2 <<= 1;
+    return pow2;
+}
+
+//Key function for configs with no keyboard. Always reports no key.
+static uint8_t getKeyNone(){
+    return CHIP8_STATE_NULL_KEY;
+}
+
+/* Fills config with standard CHIP-8 settings.
+ * Keys are read from the parent C8_State's key field. */
+void C8_StandardConfig(C8_Config *config){
+    config->memorySize = C8_MEMORY_SIZE_STANDARD;
+    config->stackSize = C8_STACK_SIZE_STANDARD;
+    config->displayHeight = C8_DISPLAY_H_STANDARD;
+    config->displayWidth = C8_DISPLAY_W_STANDARD;
+    config->fontAddress = C8_FONT_ADDRESS_STANDARD;
+    config->programAddress = C8_PROGRAM_ADDRESS_STANDARD;
+    config->keyMode = C8_CONFIG_KEYPRESS_USE_GIVEN_KEY;
+    config->getKey = getKeyNone;
+    config->getKeyBlocking = getKeyNone;
+    config->timerClock = 0;
+    config->instructionMode = C8_INSTRUCTION_MODE_STANDARD;
+}
+
 /* Creates and initialises a C8_State according to given config.
  * Returns pointer to C8_State on success.
  * Returns NULL pointer on fail.
@@ -21,13 +50,25 @@ C8_State *C8_CreateState(C8_Config *config){
         return NULL;
     }
 
-    state->memory = malloc(sizeof(uint8_t) * config->memorySize);
+    /* Memory between memorySize and the next power of two is a guard region,
+     * which masked addresses may land in. Only allocated in hardened mode. */
+#ifdef C8_HARDENED
+    uint32_t memoryAllocSize = roundPow2(config->memorySize);
+    uint32_t stackAllocSize = roundPow2(config->stackSize);
+#else
+    uint32_t memoryAllocSize = config->memorySize;
+    uint32_t stackAllocSize = config->stackSize;
+#endif
+    state->addressMask = roundPow2(config->memorySize) - 1;
+    state->stackMask = roundPow2(config->stackSize) - 1;
+
+    state->memory = malloc(sizeof(uint8_t) * memoryAllocSize);
     if (state->memory == NULL){
         C8_SetError("C8_CreateState could not allocate memory for CHIP_8 memory.");
         return NULL;
     }
 
-    state->stack = malloc(sizeof(uint16_t) * config->stackSize);
+    state->stack = malloc(sizeof(uint16_t) * stackAllocSize);
     if (state->stack == NULL){
         C8_SetError("C8_CreateState could not allocate memory for stack.");
         return NULL;
@@ -45,8 +86,8 @@ C8_State *C8_CreateState(C8_Config *config){
         return NULL;
     }
     
-    memset(state->memory, 0, sizeof(uint8_t) * config->memorySize);
-    memset(state->stack, 0, sizeof(uint16_t) * config->stackSize);
+    memset(state->memory, 0, sizeof(uint8_t) * memoryAllocSize);
+    memset(state->stack, 0, sizeof(uint16_t) * stackAllocSize);
     memset(state->display, 0, sizeof(uint8_t) * config->displayHeight * config->displayWidth);
     memcpy(state->config, config, sizeof(*config));
 
@@ -57,6 +98,8 @@ C8_State *C8_CreateState(C8_Config *config){
     state->delayTimer = 0;
     state->soundTimer = 0;
     state->key = CHIP8_STATE_NULL_KEY;
+    state->trap = NULL;
+    state->trapData = NULL;
 
     return state;
 }
@@ -55,6 +55,19 @@ static const uint8_t C8_FONT_STANDARD[] = {
  * will use values returned by parent C8_State getKey or getKeyBlocking functions. */
 #define C8_CONFIG_KEYPRESS_GET_KEY 0x2
 
+/* Hardened mode. If C8_HARDENED is defined, memory and stack are allocated
+ * rounded up to a power of two, and every address or stack index is masked
+ * into them. Hostile ROMs then wrap around instead of escaping the buffers,
+ * without adding a branch to any instruction.
+ * Otherwise, addresses and stack indices are used unchecked. */
+#ifdef C8_HARDENED
+#define C8_ADDRESS(state, address) ((address) & (state)->addressMask)
+#define C8_STACK_INDEX(state, index) ((index) & (state)->stackMask)
+#else
+#define C8_ADDRESS(state, address) (address)
+#define C8_STACK_INDEX(state, index) (index)
+#endif
+
 typedef struct C8_Config{
     uint16_t memorySize; //Size of CHIP-8 system's memory in bytes.
     uint8_t stackSize; //Size of CHIP-8 system's stack in bytes.
@@ -90,9 +103,14 @@ typedef struct C8_State{
     uint8_t *display; //Frame buffer.
     uint8_t key; //numeric value of currently pressed key.
     C8_Config *config; //State's configuration.
+    uint32_t addressMask; //Masks addresses into memory in hardened mode.
+    uint8_t stackMask; //Masks stack indices into stack in hardened mode.
+    void (*trap)(struct C8_State *state); //Called on C8_TRAP_INSTRUCTION. NULL if unused.
+    void *trapData; //Owner of trap, e.g. a C8_Debugger.
 } C8_State;
 
 
+void C8_StandardConfig(C8_Config *config);
 C8_State *C8_CreateState(C8_Config *config);
 void C8_DestroyState(C8_State *state);
 #endif
\ No newline at end of file
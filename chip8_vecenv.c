@@ -0,0 +1,170 @@
+#include "chip8_vecenv.h"
+#include "chip8_state.h"
+#include "chip8_error.h"
+#include "chip8_interpreter.h"
+#include <stdlib.h>
+#include <string.h>
+
+//Reads the instance's score from memory.
+static uint16_t readScore(C8_VecEnv *env, C8_State *state){
+    uint16_t address = env->envConfig.rewardAddress;
+
+    if (env->envConfig.rewardBytes == 2)
+        return (state->memory[address] << 8) | state->memory[address + 1];
+    if (env->envConfig.rewardBytes == 1)
+        return state->memory[address];
+    return 0;
+}
+
+//Returns the instance to its state straight after loading the ROM.
+static void resetInstance(C8_VecEnv *env, uint16_t n){
+    C8_State *state = env->states[n];
+
+    memcpy(state->memory, env->pristine, sizeof(uint8_t) * state->config->memorySize);
+    memset(state->display, 0,
+           sizeof(uint8_t) * state->config->displayHeight * state->config->displayWidth);
+    memset(state->stack, 0, sizeof(uint16_t) * state->config->stackSize);
+    state->pc = state->config->programAddress;
+    state->i = 0;
+    state->sp = 0;
+    memset(state->v, 0, sizeof(state->v));
+    state->delayTimer = 0;
+    state->soundTimer = 0;
+    state->key = CHIP8_STATE_NULL_KEY;
+
+    env->scores[n] = readScore(env, state);
+    env->done[n] = 0;
+}
+
+/* Creates count instances of config running rom, with the standard font loaded.
+ * observations must hold count * displayHeight * displayWidth bytes, and must outlive
+ * the C8_VecEnv. Instance n's display is observations[n * displayHeight * displayWidth].
+ * Instances read keys from C8_VecEnvStep's actions, whatever config's keyMode.
+ * Returns NULL on fail.
+ * Returned C8_VecEnv should be freed with C8_DestroyVecEnv. */
+C8_VecEnv *C8_CreateVecEnv(C8_Config *config, C8_VecEnvConfig *envConfig,
+                           const uint8_t *rom, size_t romLen,
+                           uint16_t count, uint8_t *observations){
+    if (config == NULL || envConfig == NULL || observations == NULL){
+        C8_SetError("C8_CreateVecEnv received NULL argument.");
+        return NULL;
+    }
+
+    if (count == 0){
+        C8_SetError("C8_CreateVecEnv received no instances.");
+        return NULL;
+    }
+
+    if ((envConfig->rewardBytes > 0 &&
+         envConfig->rewardAddress + envConfig->rewardBytes > config->memorySize) ||
+        (envConfig->doneMask != 0 && envConfig->doneAddress >= config->memorySize)){
+        C8_SetError("C8_CreateVecEnv received reward or done address outside of memory.");
+        return NULL;
+    }
+
+    C8_VecEnv *env = calloc(1, sizeof(C8_VecEnv));
+    if (env == NULL){
+        C8_SetError("C8_CreateVecEnv could not allocate memory for C8_VecEnv struct.");
+        return NULL;
+    }
+
+    env->envConfig = *envConfig;
+    env->observations = observations;
+    env->states = calloc(count, sizeof(C8_State *));
+    env->scores = calloc(count, sizeof(uint16_t));
+    env->done = calloc(count, sizeof(uint8_t));
+    env->pristine = malloc(sizeof(uint8_t) * config->memorySize);
+    if (env->states == NULL || env->scores == NULL || env->done == NULL || env->pristine == NULL){
+        C8_SetError("C8_CreateVecEnv could not allocate memory for instances.");
+        C8_DestroyVecEnv(env);
+        return NULL;
+    }
+
+    size_t frameSize = (size_t)config->displayHeight * config->displayWidth;
+    for (env->count = 0; env->count < count; env->count++){
+        C8_State *state = C8_CreateState(config);
+        if (state == NULL){
+            C8_DestroyVecEnv(env);
+            return NULL;
+        }
+
+        //Draw straight into the caller's tensor.
+        free(state->display);
+        state->display = &(observations[env->count * frameSize]);
+        state->config->keyMode = C8_CONFIG_KEYPRESS_USE_GIVEN_KEY;
+        env->states[env->count] = state;
+    }
+
+    //Every instance starts from the same image, so it is only loaded once.
+    C8_State *first = env->states[0];
+    if (!C8_LoadProgramBuffer(first, rom, romLen)){
+        C8_DestroyVecEnv(env);
+        return NULL;
+    }
+    C8_LoadFont(first, (uint8_t *)C8_FONT_STANDARD, C8_FONT_STANDARD_LEN);
+    memcpy(env->pristine, first->memory, sizeof(uint8_t) * config->memorySize);
+
+    C8_VecEnvReset(env, NULL);
+    return env;
+}
+
+/* Frees the given C8_VecEnv and its instances.
+ * The observation tensor belongs to the caller and is not freed. */
+void C8_DestroyVecEnv(C8_VecEnv *env){
+    for (uint16_t n = 0; n < env->count; n++){
+        env->states[n]->display = NULL;
+        C8_DestroyState(env->states[n]);
+    }
+
+    free(env->states);
+    free(env->scores);
+    free(env->done);
+    free(env->pristine);
+    free(env);
+}
+
+/* Resets instances n where batch[n] is set, or every instance if batch is NULL.
+ * Their observations are cleared. The dones from C8_VecEnvStep can be passed as batch. */
+void C8_VecEnvReset(C8_VecEnv *env, const uint8_t *batch){
+    for (uint16_t n = 0; n < env->count; n++){
+        if (batch == NULL || batch[n])
+            resetInstance(env, n);
+    }
+}
+
+/* Presses actions[n] (a key value, or CHIP8_STATE_NULL_KEY) on instance n,
+ * then runs it for framesToSkip frames. Observations are left in the tensor.
+ * rewards[n] is the change in instance n's score, and dones[n] is set once it is done.
+ * Done instances are not run until reset. rewards and dones may be NULL. */
+void C8_VecEnvStep(C8_VecEnv *env, const uint8_t *actions, uint16_t framesToSkip,
+                   float *rewards, uint8_t *dones){
+    for (uint16_t n = 0; n < env->count; n++){
+        C8_State *state = env->states[n];
+
+        if (!env->done[n]){
+            state->key = actions[n];
+            for (uint16_t frame = 0; frame < framesToSkip; frame++){
+                for (uint16_t cycle = 0; cycle < env->envConfig.cyclesPerFrame; cycle++)
+                    C8_FDE(state);
+
+                if (state->delayTimer > 0)
+                    state->delayTimer--;
+                if (state->soundTimer > 0)
+                    state->soundTimer--;
+
+                if (env->envConfig.doneMask &&
+                    (state->memory[env->envConfig.doneAddress] & env->envConfig.doneMask)){
+                    env->done[n] = 1;
+                    break;
+                }
+            }
+        }
+
+        uint16_t score = readScore(env, state);
+        if (rewards != NULL)
+            rewards[n] = (float)((int32_t)score - (int32_t)env->scores[n]);
+        if (dones != NULL)
+            dones[n] = env->done[n];
+        env->scores[n] = score;
+    }
+}
@@ -0,0 +1,36 @@
+#ifndef CHIP8_VECENV_H_GUARD
+#define CHIP8_VECENV_H_GUARD
+
+#include "chip8_state.h"
+#include <stddef.h>
+
+typedef struct C8_VecEnvConfig{
+    uint16_t cyclesPerFrame; //Instructions run per frame. Timers are decremented once per frame.
+    uint16_t rewardAddress; //Address of the score. Reward is its change over a step.
+    uint8_t rewardBytes; //Score size: 1, or 2 for big endian. If 0, rewards are always 0.
+    uint16_t doneAddress; //Address of the game over flag.
+    uint8_t doneMask; //Instance is done when memory[doneAddress] & doneMask. If 0, never done.
+} C8_VecEnvConfig;
+
+/* A batch of C8_States running the same ROM, for reinforcement learning.
+ * Each state's display points into one caller owned N x H x W observation tensor,
+ * so observations are written in place by the interpreter and never copied. */
+typedef struct C8_VecEnv{
+    C8_State **states; //The instances.
+    uint16_t count; //Number of instances.
+    uint8_t *observations; //Caller owned tensor, count * displayHeight * displayWidth bytes.
+    uint8_t *pristine; //Memory image with font and ROM loaded, restored on reset.
+    uint16_t *scores; //Each instance's score at the end of its last step or reset.
+    uint8_t *done; //Set for instances which are done and awaiting reset.
+    C8_VecEnvConfig envConfig; //Frame and reward settings.
+} C8_VecEnv;
+
+C8_VecEnv *C8_CreateVecEnv(C8_Config *config, C8_VecEnvConfig *envConfig,
+                           const uint8_t *rom, size_t romLen,
+                           uint16_t count, uint8_t *observations);
+void C8_DestroyVecEnv(C8_VecEnv *env);
+void C8_VecEnvReset(C8_VecEnv *env, const uint8_t *batch);
+void C8_VecEnvStep(C8_VecEnv *env, const uint8_t *actions, uint16_t framesToSkip,
+                   float *rewards, uint8_t *dones);
+
+#endif